@@ -505,8 +505,8 @@ static bool apply_rotate_action(Board& board, const Move& move, const string& pl
     return true;
 }
 
-static pair<bool, string> agent_apply_move(Board& board, const Move& move, const string& player, 
-                                           int rows, int cols, const vector<int>& score_cols) {
+pair<bool, string> agent_apply_move(Board& board, const Move& move, const string& player, 
+                                    int rows, int cols, const vector<int>& score_cols) {
     string msg;
     bool ok = false;
     
@@ -720,37 +720,7 @@ pair<bool, Board> simulate_move_on_copy(const Board& board, const Move& move,
     return {ok, cp};
 }
 
-// ==================== BASE AGENT CLASS ====================
-
-class BaseAgent {
-public:
-    string player;
-    string opponent;
-    
-    BaseAgent(const string& p) : player(p), opponent(opponent_of(p)) {}
-    virtual ~BaseAgent() = default;
-
-    // Pure virtual - must be implemented by derived classes
-    virtual optional<Move> choose(const Board& board, int rows, int cols, 
-                                 const vector<int>& score_cols, 
-                                 double current_player_time, double opponent_time) = 0;
-
-    // Helper methods available to all agents
-    vector<Move> generate_all_moves_for(const Board& board, int rows, int cols, 
-                                        const vector<int>& score_cols) {
-        return generate_all_moves(board, player, rows, cols, score_cols);
-    }
-
-    // double evaluate_board(const Board& board, int rows, int cols, 
-    //                      const vector<int>& score_cols) {
-    //     return basic_evaluate_board(board, player, rows, cols, score_cols);
-    // }
-
-    pair<bool, Board> simulate_move(const Board& board, const Move& move, 
-                                   int rows, int cols, const vector<int>& score_cols) {
-        return simulate_move_on_copy(board, move, player, rows, cols, score_cols);
-    }
-};
+// BaseAgent is declared in agent.h, so native hosts such as the arena can drive agents.
 
 // ==================== RANDOM AGENT ====================
 
@@ -781,8 +751,9 @@ unique_ptr<BaseAgent> get_agent(const string& player, const string& strategy) {
     
     if (s == "random") 
         return make_unique<RandomAgent>(player);
+    if (s == "student")
+        return make_student_agent(player);
     
-    // For student agent, would need to link with StudentAgent class
     // Fallback to random
     return make_unique<RandomAgent>(player);
 }
@@ -41,6 +41,45 @@ struct PairHash {
 struct PairEq { bool operator()(pair<int,int> a, pair<int,int> b) const noexcept { return a==b; } };
 pair<bool, Board> simulate_move_on_copy(const Board &board, const Move &move,const std::string& player, int rows, int cols, const vector<int> &score_cols);
 vector<Move> generate_all_moves(const Board &board, const string &player, int rows, int cols, const vector<int> &score_cols);
+Board create_default_start_board(int rows, int cols);
 vector<pair<int,int>> get_river_flow_destinations(
     const Board& board, int rx, int ry, int sx, int sy, const string& player,
-    int rows, int cols, const vector<int>& score_cols, bool river_push);
\ No newline at end of file
+    int rows, int cols, const vector<int>& score_cols, bool river_push);
+// Applies a move to `board` in place; false (with the reason) if it is not legal for `player`.
+pair<bool, string> agent_apply_move(Board& board, const Move& move, const string& player,
+                                    int rows, int cols, const vector<int>& score_cols);
+
+class BaseAgent {
+public:
+    string player;
+    string opponent;
+    
+    BaseAgent(const string& p) : player(p), opponent(p == "circle" ? "square" : "circle") {}
+    virtual ~BaseAgent() = default;
+
+    // Pure virtual - must be implemented by derived classes
+    virtual optional<Move> choose(const Board& board, int rows, int cols, 
+                                 const vector<int>& score_cols, 
+                                 double current_player_time, double opponent_time) = 0;
+
+    // Helper methods available to all agents
+    vector<Move> generate_all_moves_for(const Board& board, int rows, int cols, 
+                                        const vector<int>& score_cols) {
+        return generate_all_moves(board, player, rows, cols, score_cols);
+    }
+
+    // double evaluate_board(const Board& board, int rows, int cols, 
+    //                      const vector<int>& score_cols) {
+    //     return basic_evaluate_board(board, player, rows, cols, score_cols);
+    // }
+
+    pair<bool, Board> simulate_move(const Board& board, const Move& move, 
+                                   int rows, int cols, const vector<int>& score_cols) {
+        return simulate_move_on_copy(board, move, player, rows, cols, score_cols);
+    }
+};
+
+// "random" or "student"; anything else falls back to random
+unique_ptr<BaseAgent> get_agent(const string& player, const string& strategy);
+// StudentAgent (student_agent.cpp) behind the BaseAgent interface
+unique_ptr<BaseAgent> make_student_agent(const string& player);
\ No newline at end of file
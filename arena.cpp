@@ -0,0 +1,236 @@
+// arena.cpp
+// Headless self-play: plays games between two agents (see get_agent) natively, many at a
+// time, and reports the first agent's score against the second as an Elo difference with a
+// 95% confidence interval. With --sprt the run stops as soon as the sequential probability
+// ratio test accepts one of its two hypotheses.
+//
+// Usage: arena [--a student] [--b random] [--games 200] [--rows 13] [--clock 10]
+//              [--threads 0] [--openings 2] [--max-plies 500] [--seed 1]
+//              [--sprt elo0 elo1 [alpha beta]]
+//
+// Games come in pairs that share a random opening of --openings plies, with colours
+// swapped. --threads 0 takes one game per hardware thread; clocks are wall time, so more
+// threads than cores would cost both agents time. Agents that print their reasoning to
+// stdout are silenced; the report goes to stdout all the same.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "agent.h"
+#include "thread_pool.h"
+
+// student_agent.cpp
+int count_stones_in_scoring_area(const Board& board, const std::string& player, int rows, int cols, const std::vector<int>& score_cols);
+
+namespace {
+
+struct Options {
+    std::string a = "student", b = "random";
+    int games = 200;
+    int rows = 13;
+    double clock = 10;      // seconds per side and game
+    size_t threads = 0;
+    int openings = 2;       // random plies before the agents take over
+    int max_plies = 500;    // a game this long is a draw
+    unsigned seed = 1;
+    bool sprt = false;
+    double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+};
+
+// Scoring cells per board size, as the geometries in geometry.h lay them out.
+std::vector<int> score_cols_for_rows(int rows) {
+    int cols = rows - 1, w = rows == 13 ? 4 : rows == 15 ? 5 : rows == 17 ? 6 : 0;
+    if (!w) throw std::invalid_argument("--rows must be 13, 15 or 17");
+    std::vector<int> score_cols;
+    for (int i = 0; i < w; ++i) score_cols.push_back((cols - w) / 2 + i);
+    return score_cols;
+}
+
+enum Result { LOSS, DRAW, WIN }; // from the first agent's point of view
+
+struct Game {
+    Result result;
+    int plies;
+    std::string reason;
+};
+
+std::string other(const std::string& player) { return player == "circle" ? "square" : "circle"; }
+
+// One game; circle moves first. A side loses by running out of time, by an illegal or
+// missing move, or when the other side fills its scoring row.
+Game play(const Options& o, const std::vector<int>& score_cols, unsigned opening_seed, bool a_is_circle) {
+    const int rows = o.rows, cols = rows - 1, w = int(score_cols.size());
+    Board board = create_default_start_board(rows, cols);
+    std::string to_move = "circle";
+    std::mt19937 rng(opening_seed);
+    for (int i = 0; i < o.openings; ++i, to_move = other(to_move)) {
+        auto moves = generate_all_moves(board, to_move, rows, cols, score_cols);
+        if (moves.empty()) break;
+        agent_apply_move(board, moves[rng() % moves.size()], to_move, rows, cols, score_cols);
+    }
+
+    auto circle = get_agent("circle", a_is_circle ? o.a : o.b);
+    auto square = get_agent("square", a_is_circle ? o.b : o.a);
+    double circle_clock = o.clock, square_clock = o.clock;
+    auto outcome = [&](const std::string& winner, int plies, const std::string& reason) {
+        return Game{(winner == "circle") == a_is_circle ? WIN : LOSS, plies, reason};
+    };
+
+    for (int ply = 0; ply < o.max_plies; ++ply, to_move = other(to_move)) {
+        bool circle_turn = to_move == "circle";
+        BaseAgent& agent = circle_turn ? *circle : *square;
+        double& own = circle_turn ? circle_clock : square_clock;
+        double opp = circle_turn ? square_clock : circle_clock;
+
+        auto started = std::chrono::steady_clock::now();
+        std::optional<Move> move = agent.choose(board, rows, cols, score_cols, own, opp);
+        own -= std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        if (own < 0) return outcome(other(to_move), ply, "time");
+        if (!move) return outcome(other(to_move), ply, "no move");
+        if (!agent_apply_move(board, *move, to_move, rows, cols, score_cols).first)
+            return outcome(other(to_move), ply, "illegal move");
+
+        for (const std::string& side : {to_move, other(to_move)})
+            if (count_stones_in_scoring_area(board, side, rows, cols, score_cols) == w)
+                return outcome(side, ply + 1, "scoring row");
+    }
+    return Game{DRAW, o.max_plies, "move limit"};
+}
+
+// Elo difference that an expected score of s corresponds to.
+double elo(double s) {
+    if (s <= 0) return -INFINITY;
+    if (s >= 1) return INFINITY;
+    return 400 * std::log10(s / (1 - s));
+}
+
+struct Tally {
+    int n[3] = {0, 0, 0}; // LOSS, DRAW, WIN
+
+    int games() const { return n[LOSS] + n[DRAW] + n[WIN]; }
+    double mean() const { return (n[WIN] + 0.5 * n[DRAW]) / games(); }
+    // variance of a single game's score
+    double variance() const {
+        double m = mean();
+        return (n[WIN] * (1 - m) * (1 - m) + n[DRAW] * (0.5 - m) * (0.5 - m) + n[LOSS] * m * m) / games();
+    }
+
+    // Log-likelihood ratio of elo1 against elo0, with game scores taken as normally
+    // distributed around their observed variance. Half a game of each result is added, so
+    // a run of identical results still has a variance to test against.
+    double llr(double elo0, double elo1) const {
+        double w = n[WIN] + 0.5, d = n[DRAW] + 0.5, l = n[LOSS] + 0.5, total = w + d + l;
+        double m = (w + 0.5 * d) / total;
+        double var = (w * (1 - m) * (1 - m) + d * (0.5 - m) * (0.5 - m) + l * m * m) / total;
+        double s0 = 1 / (1 + std::pow(10, -elo0 / 400)), s1 = 1 / (1 + std::pow(10, -elo1 / 400));
+        return games() * (s1 - s0) * (2 * m - s0 - s1) / (2 * var);
+    }
+
+    void report(std::ostream& out) const {
+        if (!games()) { out << "no games"; return; }
+        double m = mean(), margin = 1.96 * std::sqrt(variance() / games());
+        out << std::fixed << std::setprecision(1) << "games " << games() << ": +" << n[WIN] << " =" << n[DRAW]
+            << " -" << n[LOSS] << "  score " << std::setprecision(3) << m << "  elo " << std::setprecision(1)
+            << elo(m) << " [" << elo(m - margin) << ", " << elo(m + margin) << "]";
+    }
+};
+
+Options parse(int argc, char** argv) {
+    Options o;
+    auto value = [&](int& i) -> std::string {
+        if (i + 1 >= argc) throw std::invalid_argument(std::string(argv[i]) + " needs a value");
+        return argv[++i];
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--a") o.a = value(i);
+        else if (arg == "--b") o.b = value(i);
+        else if (arg == "--games") o.games = std::stoi(value(i));
+        else if (arg == "--rows") o.rows = std::stoi(value(i));
+        else if (arg == "--clock") o.clock = std::stod(value(i));
+        else if (arg == "--threads") o.threads = std::stoul(value(i));
+        else if (arg == "--openings") o.openings = std::stoi(value(i));
+        else if (arg == "--max-plies") o.max_plies = std::stoi(value(i));
+        else if (arg == "--seed") o.seed = std::stoul(value(i));
+        else if (arg == "--sprt") {
+            o.sprt = true;
+            o.elo0 = std::stod(value(i));
+            o.elo1 = std::stod(value(i));
+            if (i + 2 < argc && argv[i + 1][0] != '-') {
+                o.alpha = std::stod(value(i));
+                o.beta = std::stod(value(i));
+            }
+        } else throw std::invalid_argument("unknown option " + arg);
+    }
+    return o;
+}
+
+// Swallows the agents' stdout chatter; it keeps no state, so every game thread can share it.
+struct NullBuffer : std::streambuf {
+    int overflow(int c) override { return c; }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    std::vector<int> score_cols;
+    try {
+        o = parse(argc, argv);
+        score_cols = score_cols_for_rows(o.rows);
+    } catch (const std::exception& e) {
+        std::cerr << "arena: " << e.what() << std::endl;
+        return 2;
+    }
+    std::ostream out(std::cout.rdbuf());
+    NullBuffer null_buffer;
+    std::cout.rdbuf(&null_buffer);
+
+    out << o.a << " vs " << o.b << ", " << o.games << " games on " << o.rows << "x" << o.rows - 1
+        << ", " << o.clock << "s per side" << std::endl;
+    const double lower = std::log(o.beta / (1 - o.alpha)), upper = std::log((1 - o.beta) / o.alpha);
+    Tally tally;
+    std::mutex tally_mutex;
+    std::atomic<bool> decided{false};
+    auto started = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(o.threads);
+        for (int g = 0; g < o.games; ++g) {
+            pool.enqueue([&, g] {
+                if (decided) return;
+                Game game = play(o, score_cols, o.seed + g / 2, g % 2 == 0);
+                std::lock_guard<std::mutex> lock(tally_mutex);
+                if (decided) return;
+                ++tally.n[game.result];
+                out << "game " << g << " (" << o.a << (g % 2 == 0 ? " circle" : " square") << "): "
+                    << (game.result == WIN ? "win" : game.result == DRAW ? "draw" : "loss") << " by "
+                    << game.reason << " after " << game.plies << " plies  ";
+                tally.report(out);
+                if (o.sprt) {
+                    double llr = tally.llr(o.elo0, o.elo1);
+                    out << "  llr " << std::setprecision(2) << llr << " (" << lower << ", " << upper << ")";
+                    if (llr <= lower || llr >= upper) decided = true;
+                }
+                out << std::endl;
+            });
+        }
+    } // the pool finishes the queued games, which return at once after an SPRT decision
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    tally.report(out);
+    out << std::setprecision(0) << "  (" << tally.games() * 3600 / seconds << " games/hour)" << std::endl;
+    if (o.sprt) {
+        double llr = tally.llr(o.elo0, o.elo1);
+        out << "SPRT elo0=" << std::setprecision(1) << o.elo0 << " elo1=" << o.elo1 << ": "
+            << (llr >= upper ? "H1 accepted" : llr <= lower ? "H0 accepted" : "inconclusive") << std::endl;
+    }
+    std::cout.rdbuf(out.rdbuf());
+    return 0;
+}
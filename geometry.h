@@ -0,0 +1,436 @@
+#pragma once
+// geometry.h
+// Compile-time board geometry for the three supported layouts (13x12, 15x14, 17x16).
+// Everything the engine's inner loops need about the board shape -- score masks,
+// neighbour tables, evaluation coordinates and Zobrist keys -- is a constexpr table
+// here, so the kernels in student_agent.cpp can be instantiated once per layout.
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+#include "agent.h"
+
+enum Side : uint8_t { CIRCLE = 0, SQUARE = 1 };
+
+inline Side side_of(const std::string& player) {
+    return player == "circle" ? CIRCLE : SQUARE;
+}
+
+inline const char* side_name(Side s) {
+    return s == CIRCLE ? "circle" : "square";
+}
+
+constexpr Side other_side(Side s) { return s == CIRCLE ? SQUARE : CIRCLE; }
+
+// Run `f(side_constant)` with the side lifted to a compile-time constant (`decltype(side)::value`).
+template <class F>
+decltype(auto) with_side(Side s, F&& f) {
+    if (s == CIRCLE) return f(std::integral_constant<Side, CIRCLE>{});
+    return f(std::integral_constant<Side, SQUARE>{});
+}
+
+// ---- Packed cells ----
+// One byte per cell: bit0 occupied, bit1 owned by square, bit2 river, bit3 vertical river.
+namespace cell {
+constexpr uint8_t EMPTY = 0;
+constexpr uint8_t OCCUPIED = 1;
+constexpr uint8_t SQUARE_OWNED = 2;
+constexpr uint8_t RIVER = 4;
+constexpr uint8_t VERTICAL = 8;
+constexpr int CODES = 16;
+
+constexpr bool empty(uint8_t c) { return c == EMPTY; }
+constexpr bool river(uint8_t c) { return c & RIVER; }
+constexpr bool vertical(uint8_t c) { return c & VERTICAL; }
+constexpr Side owner(uint8_t c) { return (c & SQUARE_OWNED) ? SQUARE : CIRCLE; }
+constexpr bool owned_by(uint8_t c, Side s) { return c != EMPTY && owner(c) == s; }
+constexpr uint8_t stone(Side s) { return OCCUPIED | (s == SQUARE ? SQUARE_OWNED : 0); }
+constexpr uint8_t as_stone(uint8_t c) { return c & (OCCUPIED | SQUARE_OWNED); }
+// a code pack_board can produce
+constexpr bool valid(uint8_t c) { return c == EMPTY || (c < CODES && (c & OCCUPIED) && (river(c) || !vertical(c))); }
+}
+
+constexpr uint16_t NO_CELL = 0xFFFF;
+
+// Symmetries of the game, combined as bit flags: SYM_MIRROR swaps left and right, SYM_FLIP
+// turns the board upside down and swaps the colours, which exchanges the scoring rows.
+enum Symmetry : uint8_t { SYM_IDENTITY = 0, SYM_MIRROR = 1, SYM_FLIP = 2 };
+
+namespace cell {
+// Cell code under a symmetry: river orientation is unchanged, owners swap on a colour flip.
+constexpr uint8_t transform(uint8_t c, int sym) { return (sym & SYM_FLIP) && c != EMPTY ? c ^ SQUARE_OWNED : c; }
+}
+
+// Neighbour order matches the direction lists used by the map-based generators.
+constexpr int DIR_DX[4] = {1, -1, 0, 0};
+constexpr int DIR_DY[4] = {0, 0, 1, -1};
+
+// splitmix64, so the Zobrist tables can be filled at compile time
+constexpr uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+template <int ROWS_, int COLS_, int SCORE_W_>
+struct Geometry {
+    static constexpr int ROWS = ROWS_;
+    static constexpr int COLS = COLS_;
+    static constexpr int CELLS = ROWS * COLS;
+    static constexpr int SCORE_W = SCORE_W_;
+    static constexpr int SCORE_COL0 = (COLS - SCORE_W) / 2;
+    static constexpr int TOP_SCORE_ROW = 2;
+    static constexpr int BOTTOM_SCORE_ROW = ROWS - 3;
+
+    static constexpr int idx(int x, int y) { return y * COLS + x; }
+    static constexpr int x_of(int i) { return i % COLS; }
+    static constexpr int y_of(int i) { return i / COLS; }
+    static constexpr bool in_bounds(int x, int y) { return 0 <= x && x < COLS && 0 <= y && y < ROWS; }
+
+    // Circle scores on the top row, square on the bottom one.
+    static constexpr int score_row(Side s) { return s == CIRCLE ? TOP_SCORE_ROW : BOTTOM_SCORE_ROW; }
+    // Row in front of the scoring row, on the far side from the board centre.
+    static constexpr int imp_row(Side s) { return s == CIRCLE ? TOP_SCORE_ROW - 1 : BOTTOM_SCORE_ROW + 1; }
+
+    static bool matches(int rows, int cols, const std::vector<int>& score_cols) {
+        if (rows != ROWS || cols != COLS || (int)score_cols.size() != SCORE_W) return false;
+        for (int i = 0; i < SCORE_W; ++i)
+            if (score_cols[i] != SCORE_COL0 + i) return false;
+        return true;
+    }
+
+private:
+    using CellMask = std::array<bool, CELLS>;
+
+    static constexpr std::array<CellMask, 2> make_score_mask() {
+        std::array<CellMask, 2> m{};
+        for (int s = 0; s < 2; ++s)
+            for (int i = 0; i < SCORE_W; ++i)
+                m[s][idx(SCORE_COL0 + i, score_row(Side(s)))] = true;
+        return m;
+    }
+
+    static constexpr std::array<std::array<int16_t, 4>, CELLS> make_neighbours() {
+        std::array<std::array<int16_t, 4>, CELLS> n{};
+        for (int i = 0; i < CELLS; ++i)
+            for (int d = 0; d < 4; ++d) {
+                int x = x_of(i) + DIR_DX[d], y = y_of(i) + DIR_DY[d];
+                n[i][d] = in_bounds(x, y) ? int16_t(idx(x, y)) : int16_t(-1);
+            }
+        return n;
+    }
+
+    static constexpr std::array<std::array<int16_t, SCORE_W>, 2> make_row_cells(bool imp) {
+        std::array<std::array<int16_t, SCORE_W>, 2> r{};
+        for (int s = 0; s < 2; ++s)
+            for (int i = 0; i < SCORE_W; ++i)
+                r[s][i] = int16_t(idx(SCORE_COL0 + i, imp ? imp_row(Side(s)) : score_row(Side(s))));
+        return r;
+    }
+
+    static constexpr std::array<std::array<int16_t, 2>, 2> make_flank_cells() {
+        std::array<std::array<int16_t, 2>, 2> f{};
+        for (int s = 0; s < 2; ++s) {
+            f[s][0] = int16_t(idx(SCORE_COL0 - 1, score_row(Side(s))));
+            f[s][1] = int16_t(idx(SCORE_COL0 + SCORE_W, score_row(Side(s))));
+        }
+        return f;
+    }
+
+    // Cells of the endgame pattern window, in the code order of pattern_db.h: the scoring
+    // row from flank to flank, then the row behind it under the scoring columns.
+    static constexpr int PATTERN_CELLS = 2 * SCORE_W + 2;
+    static constexpr std::array<std::array<int16_t, PATTERN_CELLS>, 2> make_pattern_window() {
+        std::array<std::array<int16_t, PATTERN_CELLS>, 2> w{};
+        for (int s = 0; s < 2; ++s) {
+            int n = 0;
+            for (int x = SCORE_COL0 - 1; x <= SCORE_COL0 + SCORE_W; ++x) w[s][n++] = int16_t(idx(x, score_row(Side(s))));
+            for (int x = SCORE_COL0; x < SCORE_COL0 + SCORE_W; ++x) w[s][n++] = int16_t(idx(x, imp_row(Side(s))));
+        }
+        return w;
+    }
+
+    // Cells around the opponent's scoring row where the evaluator penalises opponent pieces
+    // (indexed by the evaluating side): that row and the rows behind it up to the edge, from
+    // two columns left of the scoring columns to two right of them. Built the same way for
+    // both sides, so the evaluation commutes with the symmetries of the game.
+    static constexpr int BLOCK_ZONE_MAX = 4 * 8;
+    static constexpr std::array<std::array<int16_t, BLOCK_ZONE_MAX>, 2> make_block_zone() {
+        static_assert((ROWS - BOTTOM_SCORE_ROW) * (SCORE_W + 4) <= BLOCK_ZONE_MAX, "block zone too large");
+        std::array<std::array<int16_t, BLOCK_ZONE_MAX>, 2> z{};
+        for (int s = 0; s < 2; ++s) {
+            int n = 0;
+            int y_lo = s == CIRCLE ? BOTTOM_SCORE_ROW : 0;
+            int y_hi = s == CIRCLE ? ROWS - 1 : TOP_SCORE_ROW;
+            for (int y = y_lo; y <= y_hi; ++y)
+                for (int x = SCORE_COL0 - 2; x < SCORE_COL0 + SCORE_W + 2; ++x)
+                    if (in_bounds(x, y)) z[s][n++] = int16_t(idx(x, y));
+            for (; n < BLOCK_ZONE_MAX; ++n) z[s][n] = -1;
+        }
+        return z;
+    }
+    // The zones of the original evaluator, which basic_evaluate_board keeps reporting:
+    // circle's covers three rows, square's four, and both the columns 2..9.
+    static constexpr std::array<std::array<int16_t, BLOCK_ZONE_MAX>, 2> make_basic_block_zone() {
+        std::array<std::array<int16_t, BLOCK_ZONE_MAX>, 2> z{};
+        for (int s = 0; s < 2; ++s) {
+            int n = 0;
+            int y_lo = s == CIRCLE ? BOTTOM_SCORE_ROW : 0;
+            int y_hi = s == CIRCLE ? BOTTOM_SCORE_ROW + 2 : TOP_SCORE_ROW + 1;
+            for (int y = y_lo; y <= y_hi; ++y)
+                for (int x = 2; x <= 9; ++x)
+                    if (in_bounds(x, y)) z[s][n++] = int16_t(idx(x, y));
+            for (; n < BLOCK_ZONE_MAX; ++n) z[s][n] = -1;
+        }
+        return z;
+    }
+
+    // Every cell the search's scoring-area terms look at: both block zones, and the
+    // scoring rows from flank to flank with the rows behind them (the pattern windows).
+    static constexpr CellMask make_lane_mask() {
+        CellMask m{};
+        for (const auto& zone : make_block_zone())
+            for (int i : zone)
+                if (i >= 0) m[i] = true;
+        for (const auto& window : make_pattern_window())
+            for (int i : window) m[i] = true;
+        return m;
+    }
+
+    // Cell a position's cell i lands on under each symmetry (see Symmetry); all are involutions.
+    static constexpr std::array<std::array<int16_t, CELLS>, 4> make_sym_cells() {
+        std::array<std::array<int16_t, CELLS>, 4> t{};
+        for (int sym = 0; sym < 4; ++sym)
+            for (int i = 0; i < CELLS; ++i) {
+                int x = x_of(i), y = y_of(i);
+                if (sym & SYM_MIRROR) x = COLS - 1 - x;
+                if (sym & SYM_FLIP) y = ROWS - 1 - y;
+                t[sym][i] = int16_t(idx(x, y));
+            }
+        return t;
+    }
+
+    static constexpr std::array<std::array<uint64_t, cell::CODES>, CELLS> make_zobrist() {
+        std::array<std::array<uint64_t, cell::CODES>, CELLS> z{};
+        uint64_t state = 0x5EED0000ULL + uint64_t(ROWS) * 131 + COLS;
+        for (int i = 0; i < CELLS; ++i)
+            for (int c = 1; c < cell::CODES; ++c)
+                z[i][c] = splitmix64(state);
+        return z;
+    }
+
+    static constexpr std::array<uint64_t, 2> make_zobrist_side() {
+        uint64_t state = 0xC0FFEEULL + uint64_t(ROWS);
+        std::array<uint64_t, 2> z{};
+        z[0] = splitmix64(state);
+        z[1] = splitmix64(state);
+        return z;
+    }
+
+public:
+    static constexpr std::array<CellMask, 2> SCORE_MASK = make_score_mask();
+    static constexpr std::array<std::array<int16_t, 4>, CELLS> NEIGHBOUR = make_neighbours();
+    static constexpr std::array<std::array<int16_t, SCORE_W>, 2> SCORE_CELLS = make_row_cells(false);
+    static constexpr std::array<std::array<int16_t, SCORE_W>, 2> IMP_CELLS = make_row_cells(true);
+    static constexpr std::array<std::array<int16_t, 2>, 2> FLANK_CELLS = make_flank_cells();
+    static constexpr std::array<std::array<int16_t, BLOCK_ZONE_MAX>, 2> BLOCK_ZONE = make_block_zone();
+    static constexpr std::array<std::array<int16_t, BLOCK_ZONE_MAX>, 2> BASIC_BLOCK_ZONE = make_basic_block_zone();
+    static constexpr std::array<std::array<int16_t, PATTERN_CELLS>, 2> PATTERN_WINDOW = make_pattern_window();
+    static constexpr CellMask LANE_MASK = make_lane_mask();
+    static constexpr std::array<std::array<uint64_t, cell::CODES>, CELLS> ZOBRIST = make_zobrist();
+    static constexpr std::array<uint64_t, 2> ZOBRIST_SIDE = make_zobrist_side();
+
+    // Left-right mirroring preserves the rules only when the scoring columns are centred
+    // (13x12 and 17x16, not 15x14); the colour flip works on every layout.
+    static constexpr bool MIRROR_SYMMETRIC = 2 * SCORE_COL0 + SCORE_W == COLS;
+    static constexpr bool has_symmetry(int sym) { return MIRROR_SYMMETRIC || !(sym & SYM_MIRROR); }
+    static constexpr std::array<std::array<int16_t, CELLS>, 4> SYM_CELL = make_sym_cells();
+
+    // Scoring cell of the other side, i.e. a cell `s` may never enter.
+    static constexpr bool forbidden(int i, Side s) { return SCORE_MASK[other_side(s)][i]; }
+};
+
+using SmallBoard = Geometry<13, 12, 4>;
+using MediumBoard = Geometry<15, 14, 5>;
+using LargeBoard = Geometry<17, 16, 6>;
+
+// Run `f(G{})` with the geometry matching the runtime board description.
+template <class F>
+decltype(auto) with_geometry(int rows, int cols, const std::vector<int>& score_cols, F&& f) {
+    if (SmallBoard::matches(rows, cols, score_cols)) return f(SmallBoard{});
+    if (MediumBoard::matches(rows, cols, score_cols)) return f(MediumBoard{});
+    if (LargeBoard::matches(rows, cols, score_cols)) return f(LargeBoard{});
+    throw std::invalid_argument("unsupported board geometry " + std::to_string(rows) + "x" +
+                                std::to_string(cols));
+}
+
+// ---- Packed board and moves ----
+
+template <class G>
+struct PackedBoard {
+    std::array<uint8_t, G::CELLS> cells{};
+    uint64_t key = 0;      // Zobrist key of the pieces only; side to move is mixed in by callers
+    uint64_t lane_key = 0; // the same, restricted to the LANE_MASK cells
+    uint64_t field_key = 0; // what distance fields depend on: rivers, owners aside, and the scoring cells
+    // key of this position under each symmetry; sym_keys[0] equals key
+    std::array<uint64_t, 4> sym_keys{};
+
+    void set(int i, uint8_t c) {
+        uint64_t delta = G::ZOBRIST[i][cells[i]] ^ G::ZOBRIST[i][c];
+        key ^= delta;
+        if (G::LANE_MASK[i]) lane_key ^= delta;
+        field_key ^= field_code(i, cells[i]) ^ field_code(i, c);
+        sym_keys[0] = key;
+        for (int sym = 1; sym < 4; ++sym) {
+            if (!G::has_symmetry(sym)) continue;
+            int j = G::SYM_CELL[sym][i];
+            sym_keys[sym] ^= G::ZOBRIST[j][cell::transform(cells[i], sym)] ^ G::ZOBRIST[j][cell::transform(c, sym)];
+        }
+        cells[i] = c;
+    }
+    uint64_t key_for(Side to_move) const { return key ^ G::ZOBRIST_SIDE[to_move]; }
+    // Share of cell i holding c in field_key: scoring cells count with their owner, since
+    // they make the targets; elsewhere only rivers and their orientation count.
+    static uint64_t field_code(int i, uint8_t c) {
+        if (G::SCORE_MASK[CIRCLE][i] || G::SCORE_MASK[SQUARE][i]) return G::ZOBRIST[i][c];
+        return cell::river(c) ? G::ZOBRIST[i][c & ~cell::SQUARE_OWNED] : 0;
+    }
+
+    // Smallest key among the symmetric images of this position, and the symmetry giving it.
+    // Positions related by a symmetry share their canonical key.
+    uint64_t canonical_key(Symmetry& sym) const {
+        sym = SYM_IDENTITY;
+        for (int s = 1; s < 4; ++s)
+            if (G::has_symmetry(s) && sym_keys[s] < sym_keys[sym]) sym = Symmetry(s);
+        return sym_keys[sym];
+    }
+    // The same with the side to move, which a colour flip exchanges.
+    uint64_t canonical_key_for(Side to_move, Symmetry& sym) const {
+        uint64_t k = canonical_key(sym);
+        return k ^ G::ZOBRIST_SIDE[(sym & SYM_FLIP) ? other_side(to_move) : to_move];
+    }
+};
+
+enum class Action : uint8_t { MOVE, PUSH, FLIP, ROTATE };
+
+// Orientation carried by stone->river flips; river->stone flips use ORIENT_NONE.
+enum Orient : uint8_t { ORIENT_NONE = 0, ORIENT_H = 1, ORIENT_V = 2 };
+
+struct PackedMove {
+    uint16_t from = NO_CELL;
+    uint16_t to = NO_CELL;
+    uint16_t pushed = NO_CELL;
+    Action action = Action::MOVE;
+    Orient orient = ORIENT_NONE;
+
+    bool operator==(const PackedMove& o) const {
+        return from == o.from && to == o.to && pushed == o.pushed && action == o.action && orient == o.orient;
+    }
+};
+
+using PackedMoveList = std::vector<PackedMove>;
+
+// A move of a position mapped onto the image of that position under `sym`; applying it
+// twice gives the move back.
+template <class G>
+PackedMove transform_move(PackedMove m, int sym) {
+    if (m.from != NO_CELL) m.from = uint16_t(G::SYM_CELL[sym][m.from]);
+    if (m.to != NO_CELL) m.to = uint16_t(G::SYM_CELL[sym][m.to]);
+    if (m.pushed != NO_CELL) m.pushed = uint16_t(G::SYM_CELL[sym][m.pushed]);
+    return m;
+}
+
+template <class G>
+PackedBoard<G> pack_board(const Board& board) {
+    PackedBoard<G> pb;
+    for (int y = 0; y < G::ROWS; ++y) {
+        for (int x = 0; x < G::COLS; ++x) {
+            const auto& m = board[y][x];
+            if (m.empty()) continue;
+            uint8_t c = cell::OCCUPIED;
+            auto it = m.find("owner");
+            if (it != m.end() && it->second == "square") c |= cell::SQUARE_OWNED;
+            it = m.find("side");
+            if (it != m.end() && it->second == "river") {
+                c |= cell::RIVER;
+                auto ot = m.find("orientation");
+                if (ot != m.end() && ot->second != "horizontal") c |= cell::VERTICAL;
+            }
+            pb.set(G::idx(x, y), c);
+        }
+    }
+    return pb;
+}
+
+// The same from raw cell codes, G::CELLS of them in index order, as the batch entry points
+// take boards. False if a code is not one pack_board produces.
+template <class G>
+bool unpack_cells(const uint8_t* cells, PackedBoard<G>& pb) {
+    pb = PackedBoard<G>{};
+    for (int i = 0; i < G::CELLS; ++i) {
+        uint8_t c = cells[i];
+        if (c == cell::EMPTY) continue;
+        if (!cell::valid(c)) return false;
+        pb.set(i, c);
+    }
+    return true;
+}
+
+// Inverse of pack_board, in the layout the map-based engine builds.
+template <class G>
+Board unpack_board(const PackedBoard<G>& pb) {
+    Board board(G::ROWS, Board::value_type(G::COLS));
+    for (int i = 0; i < G::CELLS; ++i) {
+        uint8_t c = pb.cells[i];
+        if (cell::empty(c)) continue;
+        auto& m = board[G::y_of(i)][G::x_of(i)];
+        m["owner"] = side_name(cell::owner(c));
+        m["side"] = cell::river(c) ? "river" : "stone";
+        if (cell::river(c)) m["orientation"] = cell::vertical(c) ? "vertical" : "horizontal";
+    }
+    return board;
+}
+
+// Convert to the Move layout produced by generate_all_moves.
+template <class G>
+Move to_move(const PackedMove& pm) {
+    std::vector<int> from{G::x_of(pm.from), G::y_of(pm.from)};
+    switch (pm.action) {
+        case Action::MOVE:
+            return Move("move", from, {G::x_of(pm.to), G::y_of(pm.to)});
+        case Action::PUSH:
+            return Move("push", from, {G::x_of(pm.to), G::y_of(pm.to)},
+                        {G::x_of(pm.pushed), G::y_of(pm.pushed)});
+        case Action::FLIP:
+            return Move("flip", from, from, {},
+                        pm.orient == ORIENT_H ? "horizontal" : pm.orient == ORIENT_V ? "vertical" : "");
+        case Action::ROTATE:
+            return Move("rotate", from, from);
+    }
+    return Move();
+}
+
+// Inverse of to_move for moves coming from outside the engine (opening lists, Python).
+template <class G>
+PackedMove from_move(const Move& m) {
+    PackedMove pm;
+    auto cell_of = [](const std::vector<int>& v) {
+        return v.size() >= 2 && G::in_bounds(v[0], v[1]) ? uint16_t(G::idx(v[0], v[1])) : NO_CELL;
+    };
+    pm.from = cell_of(m.from);
+    if (m.action == "move" || m.action == "push") {
+        pm.action = m.action == "move" ? Action::MOVE : Action::PUSH;
+        pm.to = cell_of(m.to);
+        if (pm.action == Action::PUSH) pm.pushed = cell_of(m.pushed_to);
+    } else if (m.action == "flip") {
+        pm.action = Action::FLIP;
+        pm.orient = m.orientation == "horizontal" ? ORIENT_H : m.orientation == "vertical" ? ORIENT_V : ORIENT_NONE;
+    } else {
+        pm.action = Action::ROTATE;
+    }
+    return pm;
+}
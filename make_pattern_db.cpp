@@ -0,0 +1,24 @@
+// make_pattern_db.cpp
+// Writes the endgame pattern databases (see pattern_db.h) for the three board layouts.
+// Usage: make_pattern_db [output_dir]; the agent looks for them in its working directory.
+
+#include <iostream>
+#include "geometry.h"
+#include "pattern_db.h"
+
+template <class G>
+bool write_for(const std::string& dir) {
+    std::string path = dir + "/" + pattern_db_file(G::ROWS, G::COLS);
+    bool ok = write_pattern_db(path, G::SCORE_W);
+    std::cout << (ok ? "wrote " : "failed to write ") << path << " (" << pattern_entries(G::SCORE_W)
+              << " patterns)" << std::endl;
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : ".";
+    bool ok = write_for<SmallBoard>(dir);
+    ok = write_for<MediumBoard>(dir) && ok;
+    ok = write_for<LargeBoard>(dir) && ok;
+    return ok ? 0 : 1;
+}
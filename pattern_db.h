@@ -0,0 +1,170 @@
+#pragma once
+// pattern_db.h
+// Endgame pattern database over the few cells that decide how a scoring row is filled:
+// the scoring row with the flank cell on each end, and the row behind it. Every
+// arrangement of those cells has a precomputed distance and defensive reply, so the
+// evaluator looks them up instead of searching the same shapes every game.
+//
+// The tables only depend on the scoring width. make_pattern_db writes them to disk ahead
+// of time; PatternDb maps such a file read-only, so every agent in every process shares
+// the same pages, and builds the table in memory when no file is found.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Window cells, in code order: the scoring row from the left flank to the right flank
+// (W + 2 cells), then the row behind it under the scoring columns (W cells). Each cell is
+// one base-3 digit, the first cell being the least significant one.
+enum PatternCell : uint8_t { PATTERN_EMPTY = 0, PATTERN_OWN = 1, PATTERN_OTHER = 2 };
+
+constexpr uint8_t PATTERN_UNREACHABLE = 0xFF; // the stones in the window cannot fill the row
+constexpr uint8_t PATTERN_NO_REPLY = 0xFF;
+
+struct PatternEntry {
+    uint8_t moves_to_fill; // fewest stone steps inside the window that complete the row
+    uint8_t reply;         // window cell the defence should occupy, or PATTERN_NO_REPLY
+};
+
+inline int pattern_window_cells(int score_w) { return 2 * score_w + 2; }
+
+inline uint32_t pattern_entries(int score_w) {
+    uint32_t n = 1;
+    for (int k = 0; k < pattern_window_cells(score_w); ++k) n *= 3;
+    return n;
+}
+
+inline std::string pattern_db_file(int rows, int cols) {
+    return "pattern_db_" + std::to_string(rows) + "x" + std::to_string(cols) + ".bin";
+}
+
+// Distances come from one breadth-first search out of every filled row. Steps are
+// reversible, so the distance back to a filled row is the distance from it. Pieces of the
+// other side and rivers stay where they are. The defence may not enter our scoring cells,
+// so its reply is the flank or back-row cell that delays the fill the most.
+inline std::vector<PatternEntry> build_pattern_table(int score_w) {
+    const int n = pattern_window_cells(score_w);
+    const uint32_t entries = pattern_entries(score_w);
+    std::vector<uint32_t> pow3(n);
+    for (int k = 0; k < n; ++k) pow3[k] = k ? pow3[k - 1] * 3 : 1;
+
+    std::vector<std::vector<int>> adjacent(n);
+    auto link = [&](int a, int b) { adjacent[a].push_back(b); adjacent[b].push_back(a); };
+    for (int k = 0; k + 1 < score_w + 2; ++k) link(k, k + 1);
+    for (int j = 0; j < score_w; ++j) {
+        link(score_w + 2 + j, j + 1);
+        if (j + 1 < score_w) link(score_w + 2 + j, score_w + 3 + j);
+    }
+
+    auto digit = [&](uint32_t code, int k) { return (code / pow3[k]) % 3; };
+    std::vector<PatternEntry> table(entries, {PATTERN_UNREACHABLE, PATTERN_NO_REPLY});
+    std::vector<uint32_t> queue;
+    for (uint32_t code = 0; code < entries; ++code) {
+        bool filled = true;
+        for (int k = 1; k <= score_w && filled; ++k) filled = digit(code, k) == PATTERN_OWN;
+        if (filled) { table[code].moves_to_fill = 0; queue.push_back(code); }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t code = queue[head];
+        uint8_t next = uint8_t(std::min(table[code].moves_to_fill + 1, PATTERN_UNREACHABLE - 1));
+        for (int a = 0; a < n; ++a) {
+            if (digit(code, a) != PATTERN_OWN) continue;
+            for (int b : adjacent[a]) {
+                if (digit(code, b) != PATTERN_EMPTY) continue;
+                uint32_t moved = code - pow3[a] + pow3[b];
+                if (table[moved].moves_to_fill != PATTERN_UNREACHABLE) continue;
+                table[moved].moves_to_fill = next;
+                queue.push_back(moved);
+            }
+        }
+    }
+
+    for (uint32_t code = 0; code < entries; ++code) {
+        PatternEntry& e = table[code];
+        if (e.moves_to_fill == 0 || e.moves_to_fill == PATTERN_UNREACHABLE) continue;
+        int worst = e.moves_to_fill;
+        for (int k = 0; k < n; ++k) {
+            if ((k >= 1 && k <= score_w) || digit(code, k) != PATTERN_EMPTY) continue;
+            int d = table[code + PATTERN_OTHER * pow3[k]].moves_to_fill;
+            if (d > worst) { worst = d; e.reply = uint8_t(k); }
+        }
+    }
+    return table;
+}
+
+// File layout: a Header, then pattern_entries(score_w) PatternEntry records by code.
+struct PatternDbHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t score_w;
+    uint32_t entries;
+};
+constexpr char PATTERN_DB_MAGIC[4] = {'R', 'S', 'P', 'D'};
+constexpr uint32_t PATTERN_DB_VERSION = 1;
+
+inline bool write_pattern_db(const std::string& path, int score_w) {
+    std::vector<PatternEntry> table = build_pattern_table(score_w);
+    PatternDbHeader h;
+    std::memcpy(h.magic, PATTERN_DB_MAGIC, 4);
+    h.version = PATTERN_DB_VERSION;
+    h.score_w = uint32_t(score_w);
+    h.entries = uint32_t(table.size());
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&h), sizeof h);
+    out.write(reinterpret_cast<const char*>(table.data()), std::streamsize(table.size() * sizeof(PatternEntry)));
+    return bool(out);
+}
+
+class PatternDb {
+public:
+    PatternDb(int score_w, const std::string& path) {
+        if (!map_file(score_w, path)) {
+            table = build_pattern_table(score_w);
+            entries = table.data();
+        }
+    }
+    ~PatternDb() {
+        if (mapping) munmap(mapping, mapping_size);
+    }
+    PatternDb(const PatternDb&) = delete;
+    PatternDb& operator=(const PatternDb&) = delete;
+
+    const PatternEntry& probe(uint32_t code) const { return entries[code]; }
+    bool mapped() const { return mapping != nullptr; }
+
+private:
+    bool map_file(int score_w, const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        size_t expected = sizeof(PatternDbHeader) + pattern_entries(score_w) * sizeof(PatternEntry);
+        if (fstat(fd, &st) == 0 && size_t(st.st_size) == expected) {
+            void* p = mmap(nullptr, expected, PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) {
+                const auto* h = static_cast<const PatternDbHeader*>(p);
+                if (std::memcmp(h->magic, PATTERN_DB_MAGIC, 4) == 0 && h->version == PATTERN_DB_VERSION &&
+                    h->score_w == uint32_t(score_w)) {
+                    mapping = p;
+                    mapping_size = expected;
+                    entries = reinterpret_cast<const PatternEntry*>(h + 1);
+                } else {
+                    munmap(p, expected);
+                }
+            }
+        }
+        close(fd);
+        return mapping != nullptr;
+    }
+
+    std::vector<PatternEntry> table;
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    const PatternEntry* entries = nullptr;
+};
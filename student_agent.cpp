@@ -1,5 +1,9 @@
+// STUDENT_AGENT_NATIVE builds the agent without the Python module, for native hosts such
+// as the arena.
+#ifndef STUDENT_AGENT_NATIVE
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#endif
 #include <iostream>
 #include <string>
 #include <vector>
@@ -11,15 +15,30 @@
 #include <queue>
 #include <limits>
 #include <unordered_map>
+#include <unordered_set>
 #include <sstream>
 #include <cstdint>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <stdexcept>
+#include <exception>
+#include <cstring>
 #include "agent.h"
+#include "geometry.h"
+#include "pattern_db.h"
+#include "thread_pool.h"
 
+#ifndef STUDENT_AGENT_NATIVE
 namespace py = pybind11;
+#endif
 struct MoveScore {
-    Move move;
-    int score;
+    PackedMove move;
+    int32_t score;
     
 };
 
@@ -371,550 +390,1373 @@ int count_stones_in_scoring_area(const Board& board, const std::string& player,
     return count;
 }
 
-double euclidean_distance(const Position& p1, const Position& p2) {
-    return std::abs(p1.first - p2.first) + std::abs(p1.second - p2.second);
+// ---- Packed board kernels ----
+// Same rules as the map-based helpers above and in agent.cpp, instantiated once per
+// geometry so board size, score cells and neighbours are all compile-time constants.
+
+// River flow from `entry` (see get_river_flow_destinations in agent.cpp). Destinations are
+// written to `out` in discovery order without duplicates; returns how many were written.
+template <class G, Side S>
+int packed_river_flow(const PackedBoard<G>& board, int entry, int src, bool river_push, uint16_t* out) {
+    std::array<bool, G::CELLS> visited{};
+    std::array<bool, G::CELLS> seen{};
+    std::array<uint16_t, 2 * G::CELLS + 1> queue;
+    int head = 0, tail = 0, n = 0;
+    queue[tail++] = uint16_t(entry);
+
+    while (head < tail) {
+        int i = queue[head++];
+        if (visited[i]) continue;
+        visited[i] = true;
+
+        // For river push, treat entry cell as the source piece
+        uint8_t c = (river_push && i == entry) ? board.cells[src] : board.cells[i];
+
+        if (cell::empty(c)) {
+            if (!G::forbidden(i, S) && !seen[i]) { seen[i] = true; out[n++] = uint16_t(i); }
+            continue;
+        }
+        if (!cell::river(c)) continue;
+
+        int d0 = cell::vertical(c) ? 2 : 0;
+        for (int d = d0; d < d0 + 2; ++d) {
+            int j = G::NEIGHBOUR[i][d];
+            while (j >= 0) {
+                if (G::forbidden(j, S)) break;
+                uint8_t next = board.cells[j];
+                if (cell::empty(next)) {
+                    if (!seen[j]) { seen[j] = true; out[n++] = uint16_t(j); }
+                    j = G::NEIGHBOUR[j][d];
+                    continue;
+                }
+                if (j == src) {
+                    j = G::NEIGHBOUR[j][d];
+                    continue;
+                }
+                if (cell::river(next)) queue[tail++] = uint16_t(j);
+                break;
+            }
+        }
+    }
+    return n;
 }
 
-int count_rivers(const Board& board, const std::string& player, int rows, int cols, const std::vector<int>& score_cols) {
-    int count = 0;
-    for (int r = 0; r < rows; ++r) {
-        for (int c = 0; c < cols; ++c) {
-            const auto& piece = board[r][c];
-            if (!piece.empty() && piece.at("owner") == player && piece.at("side") == "river") {
-                count++;
+// Moves of the piece of side S on cell i, in generate_all_moves order; `add` receives each
+// one as (from, to, pushed, action[, orient]).
+template <class G, Side S, class Add>
+void generate_piece_moves(const PackedBoard<G>& board, int i, Add&& add) {
+    uint16_t flow[G::CELLS];
+    if (!cell::river(board.cells[i])) {
+        for (int d = 0; d < 4; ++d) {
+            int n = G::NEIGHBOUR[i][d];
+            if (n < 0 || G::forbidden(n, S)) continue;
+            uint8_t target = board.cells[n];
+            if (cell::empty(target)) {
+                add(i, n, NO_CELL, Action::MOVE);
+            } else if (cell::river(target)) {
+                int k = packed_river_flow<G, S>(board, n, i, false, flow);
+                for (int f = 0; f < k; ++f) add(i, flow[f], NO_CELL, Action::MOVE);
+            } else {
+                // Push a stone one cell further; never shove an opponent into our scoring row
+                int q = G::NEIGHBOUR[n][d];
+                if (q >= 0 && cell::empty(board.cells[q]) && !G::forbidden(q, S)) {
+                    if (cell::owner(target) != S && G::SCORE_MASK[S][q]) continue;
+                    add(i, n, q, Action::PUSH);
+                }
+            }
+        }
+        // generate_all_moves probes river flow before offering a flip, but flow never
+        // yields a forbidden cell, so both flips are always legal.
+        add(i, NO_CELL, NO_CELL, Action::FLIP, ORIENT_H);
+        add(i, NO_CELL, NO_CELL, Action::FLIP, ORIENT_V);
+    } else {
+        add(i, NO_CELL, NO_CELL, Action::FLIP);
+        add(i, NO_CELL, NO_CELL, Action::ROTATE); // same reasoning as flips above
+        for (int d = 0; d < 4; ++d) {
+            int n = G::NEIGHBOUR[i][d];
+            if (n < 0 || G::forbidden(n, S)) continue;
+            uint8_t target = board.cells[n];
+            if (cell::empty(target)) {
+                add(i, n, NO_CELL, Action::MOVE);
+            } else {
+                bool push = !cell::river(target);
+                int k = packed_river_flow<G, S>(board, n, i, push, flow);
+                for (int f = 0; f < k; ++f)
+                    add(i, push ? n : flow[f], push ? flow[f] : NO_CELL, push ? Action::PUSH : Action::MOVE);
             }
         }
     }
-    return count;
 }
 
-double basic_evaluate_board(const Board& board,
-                            const std::string& player,
-                            int rows, int cols,
-                            const std::vector<int>& score_cols)
-{
-    double score = 0.0;
-    const std::string opponent = get_opponent(player);
-
-    std::vector<Position> score_coordinates;
-    std::vector<Position> imp_coordinates;
-    std::vector<Position> opp_coordinates;
-    int stone_count = 0;
-
-    // ----------- SCORING COORDINATE SETUP (unchanged logic) -----------
-    if (player == "circle")
-    {
-        if (rows == 13)
-        {
-            stone_count = 4;
-            score_coordinates = {{2,4},{2,5},{2,6},{2,7}};
-            imp_coordinates   = {{1,4},{1,5},{1,6},{1,7}};
-            opp_coordinates   = {{2,3}, {2,8}};
+// Key of the position apply_packed_move would produce, without building it.
+template <class G>
+uint64_t packed_child_key(const PackedBoard<G>& board, const PackedMove& m) {
+    auto change = [&](int i, uint8_t c) { return G::ZOBRIST[i][board.cells[i]] ^ G::ZOBRIST[i][c]; };
+    uint8_t c = board.cells[m.from];
+    switch (m.action) {
+        case Action::MOVE:
+            return board.key ^ change(m.to, c) ^ change(m.from, cell::EMPTY);
+        case Action::PUSH:
+            return board.key ^ change(m.pushed, board.cells[m.to]) ^ change(m.to, cell::as_stone(c)) ^
+                   change(m.from, cell::EMPTY);
+        case Action::FLIP:
+            return board.key ^ change(m.from, cell::river(c) ? cell::as_stone(c)
+                                                             : c | cell::RIVER | (m.orient == ORIENT_V ? cell::VERTICAL : 0));
+        case Action::ROTATE:
+            return board.key ^ change(m.from, c ^ cell::VERTICAL);
+    }
+    return board.key;
+}
+
+// Drop every move that leads to the same position as an earlier one, keeping the order.
+template <class G>
+void unique_children(const PackedBoard<G>& board, PackedMoveList& moves) {
+    // open-addressed set of child keys, at most half full; 0 marks a free slot
+    thread_local std::vector<uint64_t> seen;
+    size_t slots = 64;
+    while (slots < 2 * moves.size()) slots *= 2;
+    seen.assign(slots, 0);
+    size_t kept = 0;
+    for (const auto& m : moves) {
+        uint64_t key = packed_child_key(board, m) | 1;
+        size_t h = size_t(key >> 17) & (slots - 1);
+        while (seen[h] && seen[h] != key) h = (h + 1) & (slots - 1);
+        if (seen[h]) continue;
+        seen[h] = key;
+        moves[kept++] = m;
+    }
+    moves.resize(kept);
+}
+
+// Packed equivalent of generate_all_moves, emitting moves in the same order except that a
+// move leading to the same position as an earlier one is dropped. Different river paths
+// to one landing cell, or a step next to a river that also flows there, would otherwise
+// be searched once each.
+template <class G, Side S>
+void generate_packed_moves(const PackedBoard<G>& board, PackedMoveList& moves) {
+    moves.clear();
+    auto add = [&](int from, int to, int pushed, Action a, Orient o = ORIENT_NONE) {
+        moves.push_back({uint16_t(from), uint16_t(to), uint16_t(pushed), a, o});
+    };
+    for (int i = 0; i < G::CELLS; ++i)
+        if (cell::owned_by(board.cells[i], S)) generate_piece_moves<G, S>(board, i, add);
+    unique_children(board, moves);
+}
+
+// Whether side S may play `move` on `board`. A flip turning a river back into a stone
+// matches whatever orientation it carries.
+template <class G, Side S>
+bool packed_legal(const PackedBoard<G>& board, PackedMove move) {
+    if (move.from == NO_CELL || !cell::owned_by(board.cells[move.from], S)) return false;
+    if (move.action == Action::FLIP && cell::river(board.cells[move.from])) move.orient = ORIENT_NONE;
+    bool legal = false;
+    generate_piece_moves<G, S>(board, move.from, [&](int from, int to, int pushed, Action a, Orient o = ORIENT_NONE) {
+        legal |= PackedMove{uint16_t(from), uint16_t(to), uint16_t(pushed), a, o} == move;
+    });
+    return legal;
+}
+
+// Batch move generation over boards stored as a structure of arrays: cell i of board b at
+// soa[i * n + b]. Simple steps and pushes of stones only compare a few bytes, so one pass
+// per cell works them out for every board at once, a lane per board, with the neighbour
+// cells and scoring rows as compile-time constants. Pieces whose moves depend on river
+// flow (rivers, and stones next to a river) go through generate_piece_moves per board.
+constexpr uint16_t BATCH_FLOW = 1 << 8; // bits 0-3: step in direction d, 4-7: push in direction d
+
+template <class G, Side S>
+void batch_step_bits(const uint8_t* soa, size_t n, uint16_t* bits) {
+    for (int i = 0; i < G::CELLS; ++i) {
+        const uint8_t* c = soa + size_t(i) * n;
+        uint16_t* out = bits + size_t(i) * n;
+        for (size_t b = 0; b < n; ++b) out[b] = cell::river(c[b]) ? BATCH_FLOW : 0;
+        for (int d = 0; d < 4; ++d) {
+            int nb = G::NEIGHBOUR[i][d];
+            if (nb < 0 || G::forbidden(nb, S)) continue;
+            const uint8_t* t = soa + size_t(nb) * n;
+            int q = G::NEIGHBOUR[nb][d];
+            if (q < 0 || G::forbidden(q, S)) {
+                for (size_t b = 0; b < n; ++b)
+                    out[b] |= uint16_t((t[b] == cell::EMPTY) << d | cell::river(t[b]) << 8);
+                continue;
+            }
+            // only our own stones may be pushed onto our scoring row
+            const uint8_t* pushed = soa + size_t(q) * n;
+            const bool own_only = G::SCORE_MASK[S][q];
+            for (size_t b = 0; b < n; ++b) {
+                uint8_t target = t[b];
+                bool push = target != cell::EMPTY && !cell::river(target) && pushed[b] == cell::EMPTY &&
+                            !(own_only && cell::owner(target) != S);
+                out[b] |= uint16_t((target == cell::EMPTY) << d | push << (4 + d) | cell::river(target) << 8);
+            }
         }
-        else if (rows == 15)
-        {
-            stone_count = 5;
-            score_coordinates = {{2,4},{2,5},{2,6},{2,7},{2,8}};
-            imp_coordinates   = {{1,4},{1,5},{1,6},{1,7},{1,8}};
-            opp_coordinates   = {{2,3}, {2,9}};
+    }
+}
+
+// Moves of board b given its step bits, in generate_packed_moves order and without its
+// duplicates. `board` needs its cells only; keys are filled in when a flow needs them.
+template <class G, Side S>
+void batch_board_moves(PackedBoard<G>& board, const uint16_t* bits, size_t n, size_t b, PackedMoveList& moves) {
+    moves.clear();
+    auto add = [&](int from, int to, int pushed, Action a, Orient o = ORIENT_NONE) {
+        moves.push_back({uint16_t(from), uint16_t(to), uint16_t(pushed), a, o});
+    };
+    bool flow = false;
+    for (int i = 0; i < G::CELLS; ++i) {
+        if (!cell::owned_by(board.cells[i], S)) continue;
+        uint16_t v = bits[size_t(i) * n + b];
+        if (v & BATCH_FLOW) {
+            generate_piece_moves<G, S>(board, i, add);
+            flow = true;
+            continue;
         }
-        else if (rows == 17)
-        {
-            stone_count = 6;
-            score_coordinates = {{2,5},{2,6},{2,7},{2,8},{2,9},{2,10}};
-            imp_coordinates   = {{1,5},{1,6},{1,7},{1,8},{1,9},{1,10}};
-            opp_coordinates   = {{2,4}, {2,11}};
+        for (int d = 0; d < 4; ++d) {
+            int nb = G::NEIGHBOUR[i][d];
+            if (v >> d & 1) add(i, nb, NO_CELL, Action::MOVE);
+            else if (v >> (4 + d) & 1) add(i, nb, G::NEIGHBOUR[nb][d], Action::PUSH);
         }
+        add(i, NO_CELL, NO_CELL, Action::FLIP, ORIENT_H);
+        add(i, NO_CELL, NO_CELL, Action::FLIP, ORIENT_V);
     }
-    else // square
-    {
-        if (rows == 13)
-        {
-            stone_count = 4;
-            score_coordinates = {{10,4},{10,5},{10,6},{10,7}};
-            imp_coordinates   = {{11,4},{11,5},{11,6},{11,7}};
-            opp_coordinates   = {{10,3}, {10,8}};
+    // steps, pushes and flips never reach the same position twice; only flows do
+    if (flow) {
+        PackedBoard<G> keyed;
+        unpack_cells<G>(board.cells.data(), keyed);
+        unique_children(keyed, moves);
+    }
+}
+
+// Apply a move produced by generate_packed_moves (or one already checked with check_move).
+template <class G>
+void apply_packed_move(PackedBoard<G>& board, const PackedMove& m) {
+    uint8_t c = board.cells[m.from];
+    switch (m.action) {
+        case Action::MOVE:
+            board.set(m.to, c);
+            board.set(m.from, cell::EMPTY);
+            break;
+        case Action::PUSH:
+            // River converts to stone after push (game rule)
+            board.set(m.pushed, board.cells[m.to]);
+            board.set(m.to, cell::as_stone(c));
+            board.set(m.from, cell::EMPTY);
+            break;
+        case Action::FLIP:
+            if (cell::river(c))
+                board.set(m.from, cell::as_stone(c));
+            else
+                board.set(m.from, c | cell::RIVER | (m.orient == ORIENT_V ? cell::VERTICAL : 0));
+            break;
+        case Action::ROTATE:
+            board.set(m.from, c ^ cell::VERTICAL);
+            break;
+    }
+}
+
+template <class G, Side S>
+int packed_scoring_count(const PackedBoard<G>& board) {
+    int n = 0;
+    for (int i : G::SCORE_CELLS[S])
+        if (board.cells[i] == cell::stone(S)) ++n;
+    return n;
+}
+
+// How a move of side S changes packed_scoring_count<G, S>, read off the touched cells.
+template <class G, Side S>
+int scoring_delta(const PackedBoard<G>& board, const PackedMove& m) {
+    auto scores = [](int i, uint8_t c) { return int(G::SCORE_MASK[S][i] && c == cell::stone(S)); };
+    uint8_t c = board.cells[m.from];
+    switch (m.action) {
+        case Action::MOVE:
+            return scores(m.to, c) - scores(m.from, c);
+        case Action::PUSH: {
+            uint8_t pushed = board.cells[m.to];
+            return scores(m.pushed, pushed) + scores(m.to, cell::as_stone(c)) -
+                   scores(m.to, pushed) - scores(m.from, c);
         }
-        else if (rows == 15)
-        {
-            stone_count = 5;
-            score_coordinates = {{12,4},{12,5},{12,6},{12,7},{12,8}};
-            imp_coordinates = {{13,4},{13,5},{13,6},{13,7},{13,8}};
-            opp_coordinates   = {{12,3}, {12,9}};
+        case Action::FLIP:
+            return cell::river(c) ? scores(m.from, cell::as_stone(c)) : -scores(m.from, c);
+        case Action::ROTATE:
+            break;
+    }
+    return 0;
+}
 
+// The moves of side S that change its scoring-area count, in generate_packed_moves order.
+// Neither side may enter the other's scoring cells, so only S's own moves change that
+// count. The pieces that can do it are found without generating everyone's moves: pieces
+// on or next to a scoring cell, stone pushers two cells out, and pieces next to a river
+// whose flow reaches an empty scoring cell, found by walking the flow backwards. Our own
+// pieces do not stop that walk, since one of them may be the piece that moves. Only
+// those candidates have their moves generated and checked with scoring_delta.
+template <class G, Side S>
+void scoring_moves(const PackedBoard<G>& board, PackedMoveList& moves) {
+    moves.clear();
+    std::array<bool, G::CELLS> candidate{}, reached{};
+    std::array<uint16_t, G::CELLS> queue;
+    int tail = 0;
+    auto mark = [&](int i) {
+        if (i >= 0 && cell::owned_by(board.cells[i], S)) candidate[i] = true;
+    };
+
+    for (int t : G::SCORE_CELLS[S]) {
+        mark(t);
+        if (board.cells[t] == cell::stone(S)) continue;
+        for (int d = 0; d < 4; ++d) {
+            int n = G::NEIGHBOUR[t][d];
+            mark(n);
+            if (n >= 0 && board.cells[n] == cell::stone(S)) mark(G::NEIGHBOUR[n][d]);
         }
-        else if (rows == 17)
-        {
-            stone_count = 6;
-            score_coordinates = {
-                {14,5},{14,6},{14,7},{14,8},{14,9},{14,10}
-            };
+        if (cell::empty(board.cells[t])) { reached[t] = true; queue[tail++] = uint16_t(t); }
+    }
+
+    // Rivers flowing into a reached cell, and our stones a river push could send there
+    for (int head = 0; head < tail; ++head) {
+        int x = queue[head];
+        for (int d = 0; d < 4; ++d) {
+            for (int j = G::NEIGHBOUR[x][d]; j >= 0 && !G::forbidden(j, S); j = G::NEIGHBOUR[j][d]) {
+                uint8_t c = board.cells[j];
+                if (cell::empty(c)) continue;
+                if (cell::river(c) && cell::vertical(c) == (d >= 2) && !reached[j]) {
+                    reached[j] = true;
+                    queue[tail++] = uint16_t(j);
+                }
+                if (!cell::owned_by(c, S)) break;
+                if (!cell::river(c)) {
+                    for (int e = 0; e < 4; ++e) {
+                        int r = G::NEIGHBOUR[j][e];
+                        if (r >= 0 && cell::river(board.cells[r])) mark(r);
+                    }
+                }
+            }
+        }
+        if (cell::river(board.cells[x]))
+            for (int d = 0; d < 4; ++d) mark(G::NEIGHBOUR[x][d]);
+    }
+
+    auto add = [&](int from, int to, int pushed, Action a, Orient o = ORIENT_NONE) {
+        PackedMove m{uint16_t(from), uint16_t(to), uint16_t(pushed), a, o};
+        if (scoring_delta<G, S>(board, m) != 0) moves.push_back(m);
+    };
+    for (int i = 0; i < G::CELLS; ++i)
+        if (candidate[i]) generate_piece_moves<G, S>(board, i, add);
+    unique_children(board, moves);
+}
+
+// Whether side S, to move, can complete its scoring row this move. A move raises the
+// count by at most two, so only positions that close are inspected.
+template <class G, Side S>
+bool has_winning_move(const PackedBoard<G>& board) {
+    int need = G::SCORE_W - packed_scoring_count<G, S>(board);
+    if (need > 2) return false;
+    PackedMoveList moves;
+    scoring_moves<G, S>(board, moves);
+    for (const auto& m : moves)
+        if (scoring_delta<G, S>(board, m) >= need) return true;
+    return false;
+}
 
-            imp_coordinates = {
-                {15,5},{15,6},{15,7},{15,8},{15,9},{15,10}
-            };
-            opp_coordinates   = {{14,4}, {14,11}};
+// ---- Scores ----
+// Scores are fixed-point integers (EVAL_SCALE units per evaluation point) and always
+// relative to the side they are computed for, so evaluate_board<G, S> == -evaluate_board<G, other>.
+using Score = int32_t;
+constexpr Score EVAL_SCALE = 100;
+constexpr Score EVAL_WIN = 1000000000;       // static bonus for a completed scoring row
+constexpr Score MATE = 2000000000;           // side to move has already won
+constexpr Score MATE_BOUND = MATE - 1000;    // beyond this a score is "mate in n plies"
+constexpr Score SCORE_INF = MATE + 1;
+
+constexpr double to_points(Score s) { return double(s) / EVAL_SCALE; }
+constexpr Score from_points(double p) {
+    return p >= to_points(SCORE_INF) ? SCORE_INF : p <= -to_points(SCORE_INF) ? -SCORE_INF : Score(p * EVAL_SCALE);
+}
 
+// Per-geometry fixed-point tables used by the evaluator.
+template <class G>
+struct EvalTables {
+    static constexpr Score round_score(double v) { return Score(v >= 0 ? v + 0.5 : v - 0.5); }
+
+    // w / (rows still to travel + 1) for the side's own pieces, indexed [side][y]
+    static constexpr std::array<std::array<Score, G::ROWS>, 2> make_advance(double w) {
+        std::array<std::array<Score, G::ROWS>, 2> t{};
+        for (int y = 0; y < G::ROWS; ++y) {
+            t[CIRCLE][y] = round_score(EVAL_SCALE * w / (y + 1));
+            t[SQUARE][y] = round_score(EVAL_SCALE * w / (G::ROWS - y));
         }
+        return t;
+    }
+    static constexpr std::array<Score, G::ROWS + G::COLS> make_distance() {
+        std::array<Score, G::ROWS + G::COLS> t{};
+        for (int d = 0; d < G::ROWS + G::COLS; ++d) t[d] = round_score(EVAL_SCALE * 9.0 / (d + 1.0));
+        return t;
     }
 
-    // ----------- STONES IN SCORING AREA -----------
-    int player_scoring = count_stones_in_scoring_area(board, player, rows, cols, score_cols);
-    int opponent_scoring = count_stones_in_scoring_area(board, opponent, rows, cols, score_cols);
+    static constexpr auto DISTANCE = make_distance();
+
+    // DISTANCE by distance-field value, with unreachable or far cells clamped to the last entry
+    static constexpr std::array<Score, 256> make_field_distance() {
+        constexpr auto distance = make_distance();
+        std::array<Score, 256> t{};
+        for (int d = 0; d < 256; ++d) t[d] = distance[d < G::ROWS + G::COLS ? d : G::ROWS + G::COLS - 1];
+        return t;
+    }
+    static constexpr auto FIELD_DISTANCE = make_field_distance();
+
+
+    static constexpr Score SCORING_STONE = 250 * EVAL_SCALE;
+    static constexpr Score OPP_SCORING_STONE = 240 * EVAL_SCALE;
+    static constexpr Score RIVER = 15;                  // 0.15 points
+    static constexpr Score GOAL_THREAT = 70 * EVAL_SCALE;
+    static constexpr Score IMP_LANE = 90 * EVAL_SCALE;
+    static constexpr Score FLANK = 90 * EVAL_SCALE;
+    static constexpr Score BEHIND_ROW = 40 * EVAL_SCALE;
+    static constexpr Score IMP_OCCUPIED = 10 * EVAL_SCALE;
+    // by PatternEntry::moves_to_fill; a full row is already scored as a win
+    static constexpr std::array<Score, 5> PATTERN_FILL = {0, 120 * EVAL_SCALE, 60 * EVAL_SCALE, 30 * EVAL_SCALE,
+                                                          15 * EVAL_SCALE};
+
+    // What a piece is worth by its square alone in its owner's view: the advancement and
+    // imp-row bonuses, indexed [owner][cell].
+    static constexpr std::array<std::array<Score, G::CELLS>, 2> make_own_square() {
+        constexpr auto advance = make_advance(2);
+        std::array<std::array<Score, G::CELLS>, 2> t{};
+        for (int s = 0; s < 2; ++s) {
+            for (int i = 0; i < G::CELLS; ++i) {
+                int x = G::x_of(i), y = G::y_of(i);
+                Score v = advance[s][y];
+                if (s == CIRCLE ? y < G::TOP_SCORE_ROW : y > G::BOTTOM_SCORE_ROW) v += BEHIND_ROW;
+                if (y == G::imp_row(Side(s)) && x >= G::SCORE_COL0 && x < G::SCORE_COL0 + G::SCORE_W)
+                    v += IMP_OCCUPIED;
+                t[s][i] = v;
+            }
+        }
+        return t;
+    }
+    // What a piece costs the other side's view: the opponent-advance penalty, [owner][cell].
+    static constexpr std::array<std::array<Score, G::CELLS>, 2> make_opp_square() {
+        constexpr auto opp_advance = make_advance(1.7);
+        std::array<std::array<Score, G::CELLS>, 2> t{};
+        for (int s = 0; s < 2; ++s)
+            for (int i = 0; i < G::CELLS; ++i) t[s][i] = opp_advance[s][G::y_of(i)];
+        return t;
+    }
+    static constexpr auto OWN_SQUARE = make_own_square();
+    static constexpr auto OPP_SQUARE = make_opp_square();
+
+    // Both at once, as the difference of the two views counts them.
+    static constexpr std::array<std::array<Score, G::CELLS>, 2> make_piece_square() {
+        std::array<std::array<Score, G::CELLS>, 2> t{};
+        for (int s = 0; s < 2; ++s)
+            for (int i = 0; i < G::CELLS; ++i) t[s][i] = OWN_SQUARE[s][i] + OPP_SQUARE[s][i];
+        return t;
+    }
+    static constexpr auto PIECE_SQUARE = make_piece_square();
+};
 
-    // win / loss terminal boosts
-    if (player_scoring == stone_count) score += 1e7;
-    if (opponent_scoring == stone_count) score -= 1e7;
+// The endgame pattern database of a layout, mapped from the working directory when
+// make_pattern_db has been run there and built on first use otherwise.
+template <class G>
+const PatternDb& pattern_db() {
+    static const PatternDb db(G::SCORE_W, pattern_db_file(G::ROWS, G::COLS));
+    return db;
+}
+
+// S's pattern window as a pattern_db.h code; colour-independent, so both sides share one table.
+template <class G, Side S>
+uint32_t pattern_code(const PackedBoard<G>& board) {
+    uint32_t code = 0;
+    for (int k = G::PATTERN_WINDOW[S].size() - 1; k >= 0; --k) {
+        uint8_t c = board.cells[G::PATTERN_WINDOW[S][k]];
+        code = code * 3 + (cell::empty(c) ? PATTERN_EMPTY : c == cell::stone(S) ? PATTERN_OWN : PATTERN_OTHER);
+    }
+    return code;
+}
 
-    // linear scoring bonuses
-    score += player_scoring * 250;
-    score -= opponent_scoring * 240;
+// The evaluation is half the difference of the two players' views of the position. A view
+// weighs our own progress and the opponent's threats differently, so it is not
+// antisymmetric on its own, but the difference is. It is computed in two tiers: the cheap
+// tier covers the scoring areas and the per-square piece terms and only bounds the
+// distance heuristic; distance_term computes that heuristic exactly.
+
+// Scoring-area terms of S's view, penalising opponent pieces in `block_zone` (one of
+// G::BLOCK_ZONE and G::BASIC_BLOCK_ZONE).
+template <class G, Side S, class Zone>
+Score lane_view(const PackedBoard<G>& board, const Zone& block_zone) {
+    using T = EvalTables<G>;
+    constexpr Side O = other_side(S);
+    const auto& cells = board.cells;
+    Score score = 0;
 
-    // ----------- RIVER BONUS -----------
-    score += count_rivers(board, player, rows, cols, score_cols) * 0.15;
+    // ----------- STONES IN SCORING AREA -----------
+    int player_scoring = packed_scoring_count<G, S>(board);
+    int opponent_scoring = packed_scoring_count<G, O>(board);
+    if (player_scoring == G::SCORE_W) score += EVAL_WIN;
+    if (opponent_scoring == G::SCORE_W) score -= EVAL_WIN;
+    score += player_scoring * T::SCORING_STONE;
+    score -= opponent_scoring * T::OPP_SCORING_STONE;
 
     // ----------- OPPONENT BLOCK THREAT -----------
-    if (player == "circle")
-    {
-        int y0 = bottom_score_row(rows);
-        for (int y = y0; y <= y0 + 2; ++y)
-            for (int x = 2; x <= 9; ++x)
-                if (in_bounds(x, y, rows, cols))
-                {
-                    const auto& piece = board[y][x];
-                    if (!piece.empty() && piece.at("owner") == opponent)
-                        score -= 70;
-                }
-    }
-    else // square
-    {
-        int y0 = top_score_row() + 1;
-        for (int y = 0; y <= y0; ++y)
-            for (int x = 2; x <= 9; ++x)
-                if (in_bounds(x, y, rows, cols))
-                {
-                    const auto& piece = board[y][x];
-                    if (!piece.empty() && piece.at("owner") == opponent)
-                        score -= 70;
-                }
+    for (int i : block_zone[S]) {
+        if (i < 0) break;
+        if (cell::owned_by(cells[i], O)) score -= T::GOAL_THREAT;
     }
 
     // ----------- IMPORTANT POSITION BONUSES (pre-scoring columns) -----------
-    for (const auto& coor : imp_coordinates)
-    {
-        int cy = coor.first;
-        int cx = coor.second;
+    constexpr int toward_score = S == CIRCLE ? G::COLS : -G::COLS;
+    for (int i : G::IMP_CELLS[S]) {
+        if (!cell::empty(cells[i + toward_score])) continue;
+        if (cell::owned_by(cells[i], S)) score += T::IMP_LANE;
+        else if (cell::owned_by(cells[i], O)) score -= T::IMP_LANE;
+    }
+    for (int i : G::FLANK_CELLS[S])
+        if (cell::owned_by(cells[i], O)) score -= T::FLANK;
 
-        // Bounds safety
-        if (!in_bounds(cx, cy, rows, cols)) 
-            continue;
+    // ----------- ENDGAME PATTERNS -----------
+    const PatternEntry& pattern = pattern_db<G>().probe(pattern_code<G, S>(board));
+    if (pattern.moves_to_fill < T::PATTERN_FILL.size()) score += T::PATTERN_FILL[pattern.moves_to_fill];
+
+    return score;
+}
 
-        const auto& piece = board[cy][cx];
+// Small direct-mapped cache of the scoring-area terms, from circle's point of view, keyed
+// by PackedBoard::lane_key. Those cells change far less often than the rest of the board,
+// so this is hit on many positions eval_cache has never seen.
+class LaneCache {
+public:
+    explicit LaneCache(int bits) : entries(size_t(1) << bits), mask((size_t(1) << bits) - 1) {}
 
-        // -------------------------
-        // 1. PLAYER BONUS
-        // -------------------------
-        if (!piece.empty() && piece.at("owner") == player)
-        {
-            if (player == "circle")
-            {
-                // Good if cell below is empty
-                if (cy + 1 < rows && board[cy + 1][cx].empty())
-                    score += 90;
-            }
-            else // player == "square"
-            {
-                // Good if cell above is empty
-                if (cy - 1 >= 0 && board[cy - 1][cx].empty())
-                    score += 90;
-            }
-        }
+    bool probe(uint64_t key, Score& value) const {
+        const Entry& e = entries[key & mask];
+        if (!e.used || e.key != key) return false;
+        value = e.value;
+        return true;
+    }
+    void store(uint64_t key, Score value) { entries[key & mask] = {key, value, true}; }
+    void clear() { std::fill(entries.begin(), entries.end(), Entry{}); }
 
-        // -------------------------
-        // 2. OPPONENT PENALTY
-        // -------------------------
-        if (!piece.empty() && piece.at("owner") == opponent)
-        {
-            if (player == "circle")
-            {
-                // Opponent sitting in our lane is BAD
-                if (cy + 1 < rows && board[cy + 1][cx].empty())
-                    score -= 90;   // Slightly less harsh than reward
-            }
-            else // player == "square"
-            {
-                if (cy - 1 >= 0 && board[cy - 1][cx].empty())
-                    score -= 90;
-            }
-        }
+private:
+    struct Entry { uint64_t key = 0; Score value = 0; bool used = false; };
+    std::vector<Entry> entries;
+    size_t mask;
+};
+
+template <class G, Side S>
+Score lane_terms(const PackedBoard<G>& board, LaneCache* lanes) {
+    Score circle_lanes;
+    if (!lanes || !lanes->probe(board.lane_key, circle_lanes)) {
+        circle_lanes = lane_view<G, CIRCLE>(board, G::BLOCK_ZONE) -
+                       lane_view<G, SQUARE>(board, G::BLOCK_ZONE);
+        if (lanes) lanes->store(board.lane_key, circle_lanes);
     }
-    for(const auto& coor : opp_coordinates){
-        int cy = coor.first;
-        int cx = coor.second;
+    return S == CIRCLE ? circle_lanes : -circle_lanes;
+}
 
-        // Bounds safety
-        if (!in_bounds(cx, cy, rows, cols)) 
-            continue;
+// Moves a piece of side S needs to reach one of the scoring cells it does not occupy yet,
+// by a 0-1 BFS out of those cells. A step to a neighbouring cell costs one move; travel
+// along a river and on along its axis up to the next river is free. Stones are left out,
+// so the field depends only on what PackedBoard::field_key covers and can be shared by
+// every position with the same rivers. Unreachable cells keep FIELD_FAR.
+constexpr uint8_t FIELD_FAR = 0xFF;
+
+template <class G, Side S>
+void distance_field(const PackedBoard<G>& board, uint8_t* dist) {
+    const auto& cells = board.cells;
+
+    // per cell: a bit per axis a river carries pieces along (1 = horizontal, 2 = vertical)
+    std::array<uint8_t, G::CELLS> flow{};
+    for (int i = 0; i < G::CELLS; ++i) {
+        const uint8_t c = cells[i];
+        if (!cell::river(c)) continue;
+        const int axis = cell::vertical(c) ? 1 : 0;
+        flow[i] |= uint8_t(1 << axis);
+        for (int d = 2 * axis; d < 2 * axis + 2; ++d)
+            for (int j = G::NEIGHBOUR[i][d]; j >= 0 && !cell::river(cells[j]); j = G::NEIGHBOUR[j][d])
+                flow[j] |= uint8_t(1 << axis);
+    }
 
-        const auto& piece = board[cy][cx];
-        if (!piece.empty() && piece.at("owner") == opponent)
-        {
-            score -= 90;   // Slightly less harsh than reward
+    // 0-1 BFS on a ring buffer: free edges go to the front, paid ones to the back
+    std::fill(dist, dist + G::CELLS, FIELD_FAR);
+    std::array<bool, G::CELLS> done{};
+    constexpr unsigned RING = 2048, MASK = RING - 1;
+    static_assert(RING > 4 * G::CELLS + G::SCORE_W, "ring buffer too small");
+    std::array<uint16_t, RING> ring;
+    unsigned head = 0, tail = 0;
+    for (int i : G::SCORE_CELLS[S]) {
+        if (cell::owned_by(cells[i], S)) continue;
+        dist[i] = 0;
+        ring[tail++ & MASK] = uint16_t(i);
+    }
+    while (head != tail) {
+        const int u = ring[head++ & MASK];
+        if (done[u]) continue;
+        done[u] = true;
+        const uint8_t fu = flow[u];
+        for (int dir = 0; dir < 4; ++dir) {
+            const int v = G::NEIGHBOUR[u][dir];
+            if (v < 0 || G::forbidden(v, S)) continue;
+            const uint8_t axis = uint8_t(dir < 2 ? 1 : 2), fv = flow[v];
+            const bool river_u = cell::river(cells[u]), river_v = cell::river(cells[v]);
+            const bool free = ((fu & axis) && ((fv & axis) || river_v)) || ((fv & axis) && river_u);
+            const uint8_t nd = uint8_t(dist[u] + !free);
+            if (nd >= dist[v]) continue;
+            dist[v] = nd;
+            if (free) ring[--head & MASK] = uint16_t(v);
+            else ring[tail++ & MASK] = uint16_t(v);
         }
     }
-    // ----------- MAIN LOOP THROUGH BOARD -----------
-    for (int y = 0; y < rows; ++y)
-    {
-        for (int x = 0; x < cols; ++x)
-        {
-            const auto& piece = board[y][x];
-            if (piece.empty()) continue;
-
-            const std::string& owner = piece.at("owner");
-
-            // ----------- OUR PIECE -----------
-            if (owner == player)
-            {
-                // Check if this cell was one of the scoring targets
-                Position pos = {y, x};
-                // erase-if-found is expensive → replace with boolean + manual removal
-                for (size_t i = 0; i < score_coordinates.size(); ++i)
-                {
-                    if (score_coordinates[i] == pos)
-                    {
-                        score_coordinates.erase(score_coordinates.begin() + i);
-                        break;
-                    }
-                }
+}
 
-                // advancement bonuses
-                if (player == "circle")
-                {
-                    if (y < 2) score += 40;
+// Both sides' fields, circle's first, in 2 * G::CELLS bytes.
+template <class G>
+void distance_fields(const PackedBoard<G>& board, uint8_t* fields) {
+    distance_field<G, CIRCLE>(board, fields);
+    distance_field<G, SQUARE>(board, fields + G::CELLS);
+}
 
+// Small direct-mapped cache of both sides' distance fields, keyed by
+// PackedBoard::field_key. Rivers move far less often than stones, so a search mostly
+// looks its fields up here rather than running the BFS.
+class FieldCache {
+public:
+    explicit FieldCache(int bits) : keys(size_t(1) << bits), mask((size_t(1) << bits) - 1) {}
+
+    // The fields of `board` if they are cached, else nullptr; never runs the BFS.
+    template <class G>
+    const uint8_t* find(const PackedBoard<G>& board) const {
+        if (cells != size_t(G::CELLS)) return nullptr;
+        const size_t slot = board.field_key & mask;
+        if (!keys[slot].used || keys[slot].key != board.field_key) return nullptr;
+        return &data[slot * 2 * cells];
+    }
 
-                    // general advancement
-                    score += 2 * (1.0 / (y + 1));
-                }
-                else // square
-                {
-                    if (y > rows - 3) score += 40;
+    // The fields of `board`, computed and stored on a miss.
+    template <class G>
+    const uint8_t* fields(const PackedBoard<G>& board) {
+        if (cells != size_t(G::CELLS)) {
+            cells = G::CELLS;
+            data.assign(keys.size() * 2 * cells, 0);
+            std::fill(keys.begin(), keys.end(), Entry{});
+        }
+        const size_t slot = board.field_key & mask;
+        uint8_t* f = &data[slot * 2 * cells];
+        if (!keys[slot].used || keys[slot].key != board.field_key) {
+            distance_fields(board, f);
+            keys[slot] = {board.field_key, true};
+        }
+        return f;
+    }
 
-                    score += 2 * (1.0 / (rows - y));
-                }
+private:
+    struct Entry { uint64_t key = 0; bool used = false; };
+    std::vector<Entry> keys;
+    std::vector<uint8_t> data;
+    size_t mask, cells = 0;
+};
 
-                // important column occupancy (+10)
-                for (const auto& c : imp_coordinates)
-                    if (c.first == y && c.second == x)
-                        score += 10;
+// The caches shared by one agent's evaluations.
+struct EvalCaches {
+    LaneCache lanes{14};
+    FieldCache fields{10};
+};
 
-                // distance heuristic to remaining scoring cells
-                for (const auto& tgt : score_coordinates)
-                {
-                    double dist = euclidean_distance(tgt, pos);
-                    score += 9.0 / (dist + 1.0);
-                }
-            }
+// Number of scoring cells S does not occupy yet; they pull S's pieces towards them.
+template <class G, Side S>
+int open_targets(const PackedBoard<G>& board) {
+    int n = 0;
+    for (int i : G::SCORE_CELLS[S])
+        if (!cell::owned_by(board.cells[i], S)) ++n;
+    return n;
+}
 
-            // ----------- OPPONENT PIECE PENALTIES -----------
-            else
-            {
-                if (player == "circle")
-                    score -= 1.7 * (1.0 / (rows - y));
-                else
-                    score -= 1.7 * (1.0 / (y + 1));
-            }
+// Exact distance heuristic of S's view: each piece is pulled towards the nearest open
+// scoring cell by its river-aware distance, once per open cell.
+template <class G, Side S>
+Score distance_term(const PackedBoard<G>& board, int n_open, const uint8_t* dist) {
+    using T = EvalTables<G>;
+    Score score = 0;
+    for (int i = 0; i < G::CELLS; ++i)
+        if (cell::owned_by(board.cells[i], S)) score += T::FIELD_DISTANCE[dist[i]];
+    return n_open * score;
+}
+
+template <class G, Side S>
+Score distance_term(const PackedBoard<G>& board, int n_open) {
+    std::array<uint8_t, G::CELLS> dist;
+    distance_field<G, S>(board, dist.data());
+    return distance_term<G, S>(board, n_open, dist.data());
+}
+
+// Side-relative evaluation with a lazy second tier. Given `fields` (see distance_fields),
+// the distance heuristic is a lookup per piece in the cheap pass. Without them, the fields
+// of this position are only computed when the cheap tier plus the bounds on the distance
+// heuristic still reaches into [alpha, beta], and then stored in `field_cache` if there is
+// one; otherwise that bound is returned (fail-soft) and `exact` is cleared.
+template <class G, Side S>
+Score evaluate_window(const PackedBoard<G>& board, Score alpha, Score beta, bool& exact,
+                      LaneCache* lanes, const uint8_t* fields, FieldCache* field_cache = nullptr) {
+    using T = EvalTables<G>;
+    constexpr Side O = other_side(S);
+    const int open_us = open_targets<G, S>(board);
+    const int open_them = open_targets<G, O>(board);
+    const uint8_t* field_us = fields ? fields + S * G::CELLS : nullptr;
+    const uint8_t* field_them = fields ? fields + O * G::CELLS : nullptr;
+
+    // ----------- CHEAP TIER -----------
+    Score cheap = lane_terms<G, S>(board, lanes);
+    Score dist_us = 0, dist_them = 0;
+    int pieces_us = 0, pieces_them = 0;
+    for (int i = 0; i < G::CELLS; ++i) {
+        uint8_t c = board.cells[i];
+        if (cell::empty(c)) continue;
+        Score v = T::PIECE_SQUARE[cell::owner(c)][i] + (cell::river(c) ? T::RIVER : 0);
+        if (cell::owner(c) == S) {
+            cheap += v;
+            ++pieces_us;
+            if (field_us) dist_us += T::FIELD_DISTANCE[field_us[i]];
+        } else {
+            cheap -= v;
+            ++pieces_them;
+            if (field_them) dist_them += T::FIELD_DISTANCE[field_them[i]];
         }
     }
+    dist_us *= open_us;
+    dist_them *= open_them;
+
+    constexpr Score near = T::DISTANCE[0], far = T::DISTANCE[G::ROWS + G::COLS - 1];
+    const bool known_us = field_us || !open_us, known_them = field_them || !open_them;
+    const Score us_lo = known_us ? dist_us : pieces_us * open_us * far;
+    const Score us_hi = known_us ? dist_us : pieces_us * open_us * near;
+    const Score them_lo = known_them ? dist_them : pieces_them * open_them * far;
+    const Score them_hi = known_them ? dist_them : pieces_them * open_them * near;
+    const Score upper = (cheap + us_hi - them_lo) / 2;
+    const Score lower = (cheap + us_lo - them_hi) / 2;
+
+    exact = upper == lower;
+    if (exact || upper <= alpha) return upper;
+    if (lower >= beta) return lower;
+
+    // ----------- EXPENSIVE TIER -----------
+    exact = true;
+    if (field_cache && (!known_us || !known_them)) {
+        fields = field_cache->fields(board);
+        if (!known_us) dist_us = distance_term<G, S>(board, open_us, fields + S * G::CELLS);
+        if (!known_them) dist_them = distance_term<G, O>(board, open_them, fields + O * G::CELLS);
+        return (cheap + dist_us - dist_them) / 2;
+    }
+    if (!known_us) dist_us = distance_term<G, S>(board, open_us);
+    if (!known_them) dist_them = distance_term<G, O>(board, open_them);
+    return (cheap + dist_us - dist_them) / 2;
+}
 
-    return score;
+// The same with the caches in `caches`: fields already cached are used in the cheap tier,
+// and missing ones are only computed (and cached) if the expensive tier runs.
+template <class G, Side S>
+Score evaluate_window(const PackedBoard<G>& board, Score alpha, Score beta, bool& exact,
+                      EvalCaches* caches = nullptr) {
+    if (!caches) return evaluate_window<G, S>(board, alpha, beta, exact, nullptr, nullptr);
+    return evaluate_window<G, S>(board, alpha, beta, exact, &caches->lanes, caches->fields.find(board),
+                                 &caches->fields);
+}
+
+// Side-relative evaluation: evaluate_board<G, S> == -evaluate_board<G, other_side(S)>.
+template <class G, Side S>
+Score evaluate_board(const PackedBoard<G>& board, EvalCaches* caches = nullptr) {
+    bool exact;
+    return evaluate_window<G, S>(board, -SCORE_INF, SCORE_INF, exact, caches);
+}
+
+// S's view on its own, the score basic_evaluate_board reports, with the original evaluator's
+// block zones. The search scores positions by half the difference of the two views instead,
+// so that the value is side-relative, and uses the symmetric zones.
+template <class G, Side S>
+Score player_view(const PackedBoard<G>& board) {
+    using T = EvalTables<G>;
+    Score score = lane_view<G, S>(board, G::BASIC_BLOCK_ZONE);
+    for (int i = 0; i < G::CELLS; ++i) {
+        uint8_t c = board.cells[i];
+        if (cell::empty(c)) continue;
+        if (cell::owner(c) == S) score += T::OWN_SQUARE[S][i] + (cell::river(c) ? T::RIVER : 0);
+        else score -= T::OPP_SQUARE[cell::owner(c)][i];
+    }
+    return score + distance_term<G, S>(board, open_targets<G, S>(board));
+}
+
+double basic_evaluate_board(const Board& board,
+                            const std::string& player,
+                            int rows, int cols,
+                            const std::vector<int>& score_cols)
+{
+    return with_geometry(rows, cols, score_cols, [&](auto geometry) {
+        using G = decltype(geometry);
+        return with_side(side_of(player), [&](auto side) {
+            return to_points(player_view<G, decltype(side)::value>(pack_board<G>(board)));
+        });
+    });
+}
+
+// Worker threads shared by the batch entry points.
+ThreadPool& shared_pool() {
+    static ThreadPool pool;
+    return pool;
 }
 
+// Boards as the batch entry points take them: G::CELLS cell codes per board, in index order
+// (y * cols + x), back to back.
+std::string pack_boards(const std::vector<Board>& boards, int rows, int cols, const std::vector<int>& score_cols) {
+    return with_geometry(rows, cols, score_cols, [&](auto geometry) {
+        using G = decltype(geometry);
+        std::string out(boards.size() * G::CELLS, '\0');
+        for (size_t i = 0; i < boards.size(); ++i) {
+            PackedBoard<G> pb = pack_board<G>(boards[i]);
+            std::memcpy(&out[i * G::CELLS], pb.cells.data(), G::CELLS);
+        }
+        return out;
+    });
+}
+
+// basic_evaluate_board over a buffer of packed boards (see pack_boards), spread over the
+// shared thread pool.
+std::vector<double> evaluate_packed_boards(const std::string& cells, const std::string& player, int rows, int cols, const std::vector<int>& score_cols) {
+    return with_geometry(rows, cols, score_cols, [&](auto geometry) {
+        using G = decltype(geometry);
+        if (cells.size() % G::CELLS)
+            throw std::invalid_argument("buffer size is not a multiple of " + std::to_string(G::CELLS) + " cells");
+        const size_t n = cells.size() / G::CELLS;
+        const auto* data = reinterpret_cast<const uint8_t*>(cells.data());
+        std::vector<double> scores(n);
+        std::atomic<bool> invalid{false};
+        with_side(side_of(player), [&](auto side) {
+            constexpr Side S = decltype(side)::value;
+            shared_pool().parallel_for(n, [&](size_t i) {
+                PackedBoard<G> board;
+                if (!unpack_cells<G>(data + i * G::CELLS, board)) { invalid = true; return; }
+                scores[i] = to_points(player_view<G, S>(board));
+            });
+        });
+        if (invalid) throw std::invalid_argument("invalid cell code in board buffer");
+        return scores;
+    });
+}
+
+// Moves of many boards at once: counts[b] moves for board b, stored one board after the
+// other in `moves` as four little-endian uint16 fields each: from, to, pushed (cell indices,
+// 0xFFFF when unused) and the action (MOVE, PUSH, FLIP, ROTATE) plus the orientation << 8.
+struct MoveBatch {
+    std::vector<uint32_t> counts;
+    std::string moves;
+};
+
+// The same layout as pack_boards, transposed into a structure of arrays: cell i of board b
+// at byte i * len(boards) + b.
+std::string pack_boards_soa(const std::vector<Board>& boards, int rows, int cols, const std::vector<int>& score_cols) {
+    return with_geometry(rows, cols, score_cols, [&](auto geometry) {
+        using G = decltype(geometry);
+        const size_t n = boards.size();
+        std::string out(n * G::CELLS, '\0');
+        for (size_t b = 0; b < n; ++b) {
+            PackedBoard<G> pb = pack_board<G>(boards[b]);
+            for (int i = 0; i < G::CELLS; ++i) out[size_t(i) * n + b] = char(pb.cells[i]);
+        }
+        return out;
+    });
+}
+
+// generate_packed_moves for `player` on every board of a structure-of-arrays buffer (see
+// pack_boards_soa), the per-board part spread over the shared thread pool.
+MoveBatch generate_moves_soa(const std::string& soa, const std::string& player, int rows, int cols, const std::vector<int>& score_cols) {
+    return with_geometry(rows, cols, score_cols, [&](auto geometry) {
+        using G = decltype(geometry);
+        if (soa.size() % G::CELLS)
+            throw std::invalid_argument("buffer size is not a multiple of " + std::to_string(G::CELLS) + " cells");
+        const size_t n = soa.size() / G::CELLS;
+        const auto* cells = reinterpret_cast<const uint8_t*>(soa.data());
+        if (!std::all_of(cells, cells + soa.size(), cell::valid))
+            throw std::invalid_argument("invalid cell code in board buffer");
+
+        std::vector<PackedMoveList> per_board(n);
+        std::vector<uint16_t> bits(soa.size());
+        with_side(side_of(player), [&](auto side) {
+            constexpr Side S = decltype(side)::value;
+            batch_step_bits<G, S>(cells, n, bits.data());
+            shared_pool().parallel_for(n, [&](size_t b) {
+                PackedBoard<G> board;
+                for (int i = 0; i < G::CELLS; ++i) board.cells[i] = cells[size_t(i) * n + b];
+                batch_board_moves<G, S>(board, bits.data(), n, b, per_board[b]);
+            });
+        });
+
+        MoveBatch batch;
+        batch.counts.resize(n);
+        size_t total = 0;
+        for (size_t b = 0; b < n; ++b) total += batch.counts[b] = uint32_t(per_board[b].size());
+        batch.moves.resize(total * 4 * sizeof(uint16_t));
+        auto* out = reinterpret_cast<uint16_t*>(&batch.moves[0]);
+        for (const auto& moves : per_board) {
+            for (const auto& m : moves) {
+                *out++ = m.from;
+                *out++ = m.to;
+                *out++ = m.pushed;
+                *out++ = uint16_t(uint16_t(m.action) | uint16_t(m.orient) << 8);
+            }
+        }
+        return batch;
+    });
+}
 
-MoveList order_moves(const Board& board,const MoveList& moves, const std::string& player, int rows, int cols, const std::vector<int>& score_cols){
-    vector<MoveScore> ordered_moves;
-    ordered_moves.reserve(moves.size()); // Pre-reserve to avoid reallocations
-    for(const auto& move: moves){ // Use reference to avoid copying
-        auto [message, new_board] = simulate_move_on_copy(board, move, player, rows, cols, score_cols);
-        if(!message) continue;
-        double score = basic_evaluate_board(new_board, player, rows, cols, score_cols);
-        ordered_moves.push_back({move, static_cast<int>(score)});
+template <class G, Side S>
+PackedMoveList order_moves(const PackedBoard<G>& board, const PackedMoveList& moves, EvalCaches* caches = nullptr) {
+    // Children are scored against the fields of this position rather than their own, so
+    // ordering runs no BFS per child; the search evaluates each position exactly.
+    std::array<uint8_t, 2 * G::CELLS> own_fields;
+    const uint8_t* fields = own_fields.data();
+    if (caches) fields = caches->fields.fields(board);
+    else distance_fields(board, own_fields.data());
+    std::vector<MoveScore> ordered_moves;
+    ordered_moves.reserve(moves.size());
+    for (const auto& move : moves) {
+        PackedBoard<G> child = board;
+        apply_packed_move(child, move);
+        bool exact;
+        Score score = evaluate_window<G, S>(child, -SCORE_INF, SCORE_INF, exact, caches ? &caches->lanes : nullptr, fields);
+        ordered_moves.push_back({move, score});
     }
     std::sort(ordered_moves.begin(), ordered_moves.end(), [](const MoveScore& a, const MoveScore& b) {
         return a.score > b.score;
     });
-    MoveList result;
-    result.reserve(ordered_moves.size()); // Pre-reserve for result
-    for(const auto& mvscore : ordered_moves){ // Use reference
+    PackedMoveList result;
+    result.reserve(ordered_moves.size());
+    for (const auto& mvscore : ordered_moves) {
         result.push_back(mvscore.move);
     }
+    // when the opponent's scoring row matches a pattern with a known block, try it first
+    const PatternEntry& pattern = pattern_db<G>().probe(pattern_code<G, other_side(S)>(board));
+    if (pattern.reply != PATTERN_NO_REPLY) {
+        uint16_t block = uint16_t(G::PATTERN_WINDOW[other_side(S)][pattern.reply]);
+        std::stable_partition(result.begin(), result.end(), [&](const PackedMove& m) {
+            return m.action == Action::MOVE ? m.to == block : m.action == Action::PUSH && (m.to == block || m.pushed == block);
+        });
+    }
     return result;
 }
 
-// ---- Move Simulation ----
+// ---- Proof-number search ----
+// Best-first search for a forced scoring win of side Att, which is to move at the root.
+// Positions with Att to move are OR nodes, the others AND nodes. Nodes keep only the move
+// leading to them, so the board is rebuilt by replaying moves from the root on the way
+// down. A side that can complete its row on the move decides its node at once, so lines
+// end one move before the actual win.
+enum class ProofResult { PROVEN, DISPROVEN, UNKNOWN };
 
-Board simulate_move_cpp(const Board& board, const Move& move, const std::string& player, int rows, int cols, const std::vector<int>& score_cols) {
-    auto [message, new_board] = simulate_move_on_copy(board, move, player, rows, cols, score_cols);
-    if (!message) {
-        cout << "message: " << message << endl;
-        cout << "move: " << move.action << endl;
-        cout << "from: " << move.from[0] << ", " << move.from[1] << endl;
-        cout << "to: " << move.to[0] << ", " << move.to[1] << endl;
+template <class G, Side Att>
+class ProofNumberSearch {
+public:
+    ProofResult solve(const PackedBoard<G>& root, size_t node_budget) {
+        nodes.clear();
+        nodes.push_back({});
+        set_leaf<Att>(nodes[0], root);
+        PackedBoard<G> board;
+        while (!decided(nodes[0]) && nodes.size() < node_budget) {
+            board = root;
+            int i = 0;
+            while (nodes[i].n_children) {
+                i = most_proving_child(i);
+                apply_packed_move(board, nodes[i].move);
+            }
+            if (or_node(i)) expand<Att>(i, board);
+            else expand<other_side(Att)>(i, board);
+            for (; i >= 0; i = nodes[i].parent) update(i);
+        }
+        if (nodes[0].pn == 0) return ProofResult::PROVEN;
+        if (nodes[0].dn == 0) return ProofResult::DISPROVEN;
+        return ProofResult::UNKNOWN;
+    }
 
-        throw std::runtime_error("Invalid move: ");
+    // Att's winning line after a PROVEN result: Att plays the first proving move, the
+    // defence the first reply, and so on; Att's completing move ends it.
+    PackedMoveList winning_line(const PackedBoard<G>& root) const {
+        PackedMoveList line;
+        PackedBoard<G> board = root;
+        int i = 0;
+        while (nodes[i].n_children) {
+            int c = nodes[i].first_child;
+            while (or_node(i) && nodes[c].pn != 0) ++c;
+            i = c;
+            line.push_back(nodes[i].move);
+            apply_packed_move(board, nodes[i].move);
+        }
+        if (packed_scoring_count<G, Att>(board) < G::SCORE_W) {
+            PackedMoveList moves;
+            scoring_moves<G, Att>(board, moves);
+            int need = G::SCORE_W - packed_scoring_count<G, Att>(board);
+            for (const auto& m : moves)
+                if (scoring_delta<G, Att>(board, m) >= need) { line.push_back(m); break; }
+        }
+        return line;
     }
-    return new_board;
-}
-Board empty_board(int rows, int cols) {
-    Board board(rows, std::vector<std::map<std::string, std::string>>(cols));
-    return board;
-}
 
-class ZobristHash {
+    size_t size() const { return nodes.size(); }
+
 private:
-    static constexpr int MAX_ROWS = 20;
-    static constexpr int MAX_COLS = 20;
-    static std::array<std::array<std::array<std::array<std::array<uint64_t, 3>, 2>, 2>, MAX_COLS>, MAX_ROWS> zobrist_table;
-    static uint64_t player_hash[2]; // Hash for player to move: 0=circle, 1=square
-    static bool initialized;
-    
-    static void initialize_zobrist() {
-        if (initialized) return;
-        
-        std::mt19937_64 rng(12345); // Fixed seed for reproducibility
-        std::uniform_int_distribution<uint64_t> dist;
-        
-        // Initialize player hash
-        player_hash[0] = dist(rng); // circle
-        player_hash[1] = dist(rng); // square
-        
-        // Initialize position/state table
-        for (int y = 0; y < MAX_ROWS; ++y) {
-            for (int x = 0; x < MAX_COLS; ++x) {
-                for (int owner = 0; owner < 2; ++owner) {
-                    for (int side = 0; side < 2; ++side) {
-                        for (int orient = 0; orient < 3; ++orient) {
-                            zobrist_table[y][x][owner][side][orient] = dist(rng);
-                        }
-                    }
-                }
-            }
-        }
-        initialized = true;
+    static constexpr uint32_t INF = 1u << 30;
+    struct Node {
+        PackedMove move;
+        int parent = -1;
+        int first_child = 0;
+        int n_children = 0;
+        uint8_t depth = 0;
+        uint32_t pn = 1, dn = 1;
+    };
+    std::vector<Node> nodes;
+
+    static bool decided(const Node& n) { return n.pn == 0 || n.dn == 0; }
+    bool or_node(int i) const { return nodes[i].depth % 2 == 0; }
+    static void set_proven(Node& n, bool proven) { n.pn = proven ? 0 : INF; n.dn = proven ? INF : 0; }
+
+    // Static result of a position with S to move; undecided leaves keep pn = dn = 1.
+    template <Side S>
+    static void set_leaf(Node& n, const PackedBoard<G>& board) {
+        if (packed_scoring_count<G, Att>(board) == G::SCORE_W) set_proven(n, true);
+        else if (packed_scoring_count<G, other_side(Att)>(board) == G::SCORE_W) set_proven(n, false);
+        else if (has_winning_move<G, S>(board)) set_proven(n, S == Att);
     }
-    
-public:
-    static uint64_t compute_hash(const Board& board, const std::string& to_move, int rows, int cols) {
-        initialize_zobrist();
-        
-        uint64_t hash = 0;
-        
-        // Hash board state
-        for (int y = 0; y < rows && y < MAX_ROWS; ++y) {
-            for (int x = 0; x < cols && x < MAX_COLS; ++x) {
-                const auto& cell = board[y][x];
-                if (cell.empty()) continue;
-                
-                int owner = 0;
-                int side = 0;
-                int orient = 0;
-                
-                auto itO = cell.find("owner");
-                if (itO != cell.end() && itO->second == "square") owner = 1;
-                
-                auto itS = cell.find("side");
-                if (itS != cell.end() && itS->second == "river") {
-                    side = 1;
-                    auto itR = cell.find("orientation");
-                    if (itR != cell.end()) {
-                        orient = (itR->second == "horizontal") ? 1 : 2;
-                    }
-                }
-                
-                hash ^= zobrist_table[y][x][owner][side][orient];
-            }
+
+    int most_proving_child(int i) const {
+        const Node& n = nodes[i];
+        int best = n.first_child;
+        for (int c = best + 1; c < n.first_child + n.n_children; ++c) {
+            if (or_node(i) ? nodes[c].pn < nodes[best].pn : nodes[c].dn < nodes[best].dn) best = c;
         }
-        
-        // Hash player to move
-        int player_idx = (to_move == "circle") ? 0 : 1;
-        hash ^= player_hash[player_idx];
-        
-        return hash;
+        return best;
     }
-    
-    static uint64_t update_hash_remove(uint64_t hash, int x, int y, const std::map<std::string, std::string>& cell) {
-        if (y >= MAX_ROWS || x >= MAX_COLS || cell.empty()) return hash;
-        
-        int owner = 0;
-        int side = 0;
-        int orient = 0;
-        
-        auto itO = cell.find("owner");
-        if (itO != cell.end() && itO->second == "square") owner = 1;
-        
-        auto itS = cell.find("side");
-        if (itS != cell.end() && itS->second == "river") {
-            side = 1;
-            auto itR = cell.find("orientation");
-            if (itR != cell.end()) {
-                orient = (itR->second == "horizontal") ? 1 : 2;
-            }
+
+    // Children are appended contiguously; generation stops once one of them decides the node.
+    template <Side S>
+    void expand(int i, const PackedBoard<G>& board) {
+        PackedMoveList moves;
+        generate_packed_moves<G, S>(board, moves);
+        nodes[i].first_child = int(nodes.size());
+        if (moves.empty()) { set_proven(nodes[i], false); return; } // no move: not a win
+        for (const auto& m : moves) {
+            PackedBoard<G> child = board;
+            apply_packed_move(child, m);
+            Node n;
+            n.move = m;
+            n.parent = i;
+            n.depth = uint8_t(nodes[i].depth + 1);
+            set_leaf<other_side(S)>(n, child);
+            nodes.push_back(n);
+            ++nodes[i].n_children;
+            if (S == Att ? n.pn == 0 : n.dn == 0) break;
         }
-        
-        return hash ^ zobrist_table[y][x][owner][side][orient];
     }
-    
-    static uint64_t update_hash_add(uint64_t hash, int x, int y, const std::map<std::string, std::string>& cell) {
-        if (y >= MAX_ROWS || x >= MAX_COLS || cell.empty()) return hash;
-        
-        int owner = 0;
-        int side = 0;
-        int orient = 0;
-        
-        auto itO = cell.find("owner");
-        if (itO != cell.end() && itO->second == "square") owner = 1;
-        
-        auto itS = cell.find("side");
-        if (itS != cell.end() && itS->second == "river") {
-            side = 1;
-            auto itR = cell.find("orientation");
-            if (itR != cell.end()) {
-                orient = (itR->second == "horizontal") ? 1 : 2;
-            }
+
+    void update(int i) {
+        Node& n = nodes[i];
+        if (!n.n_children) return;
+        uint32_t min_pn = INF, min_dn = INF, sum_pn = 0, sum_dn = 0;
+        for (int c = n.first_child; c < n.first_child + n.n_children; ++c) {
+            min_pn = std::min(min_pn, nodes[c].pn);
+            min_dn = std::min(min_dn, nodes[c].dn);
+            sum_pn = std::min(INF, sum_pn + nodes[c].pn);
+            sum_dn = std::min(INF, sum_dn + nodes[c].dn);
         }
-        
-        return hash ^ zobrist_table[y][x][owner][side][orient];
+        if (or_node(i)) { n.pn = min_pn; n.dn = sum_dn; }
+        else { n.pn = sum_pn; n.dn = min_dn; }
     }
-    
-    static uint64_t update_hash_player(uint64_t hash, const std::string& old_player, const std::string& new_player) {
-        int old_idx = (old_player == "circle") ? 0 : 1;
-        int new_idx = (new_player == "circle") ? 0 : 1;
-        hash ^= player_hash[old_idx];
-        hash ^= player_hash[new_idx];
-        return hash;
+};
+
+// ---- Time management ----
+// Budget for one move out of both clocks. The soft budget is what a move normally gets:
+// iterative deepening starts no iteration after it has run out, and it grows while the best
+// move keeps changing and shrinks once the best move has settled. The hard budget aborts the
+// running iteration. Moves left are estimated from the board size, the moves played so far
+// and how close either side is to filling its row.
+class TimeManager {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Clocks in seconds; `progress` runs from 0 (no stone on a scoring cell) to 1 (a row is
+    // full), `branching` is the number of root moves.
+    void start(double my_time, double opponent_time, int rows, int moves_played, double progress,
+               size_t branching) {
+        begin = last_iteration = Clock::now();
+        double moves_left = (expected_moves(rows) - moves_played) * (1.0 - PHASE_WEIGHT * progress);
+        moves_left = std::max(moves_left, MIN_MOVES_LEFT);
+        // spend part of a lead over the opponent's clock, save part of a deficit
+        double base = (my_time + CLOCK_LEAD_SHARE * (my_time - opponent_time)) / moves_left;
+        double usable = std::max(0.0, my_time - SAFETY_MARGIN);
+        soft = std::clamp(base, 0.0, usable * MAX_SOFT_SHARE);
+        hard = std::min(soft * HARD_FACTOR, usable * MAX_HARD_SHARE);
+        // alpha-beta visits about the square root of the moves at every other ply
+        growth = std::clamp(std::sqrt(double(branching)), MIN_GROWTH, MAX_GROWTH);
+        previous_cost = 0;
+        best = NO_BEST;
+        stable = 0;
+    }
+
+    Clock::time_point deadline() const {
+        return begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(hard));
+    }
+
+    // Record a finished iteration and its best root move; true if another one fits.
+    bool next_iteration(size_t best_move) {
+        auto now = Clock::now();
+        double cost = seconds(last_iteration, now), used = seconds(begin, now);
+        last_iteration = now;
+        if (previous_cost > MIN_MEASURED_COST)
+            growth = std::clamp(cost / previous_cost, MIN_GROWTH, MAX_GROWTH);
+        previous_cost = cost;
+        bool changed = best != NO_BEST && best_move != best;
+        stable = changed ? 0 : stable + 1;
+        best = best_move;
+        double target = soft * (changed ? UNSTABLE_FACTOR : stable > STABLE_ITERATIONS ? STABLE_FACTOR : 1.0);
+        return used < std::min(target, hard) && used + cost * growth < hard;
     }
+
+private:
+    static double seconds(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double>(to - from).count();
+    }
+    static double expected_moves(int rows) { return rows <= 13 ? 45 : rows <= 15 ? 55 : 65; }
+
+    static constexpr size_t NO_BEST = size_t(-1);
+    static constexpr double MIN_MOVES_LEFT = 12;
+    static constexpr double PHASE_WEIGHT = 0.5;
+    static constexpr double CLOCK_LEAD_SHARE = 0.5;
+    static constexpr double SAFETY_MARGIN = 0.5;
+    static constexpr double MAX_SOFT_SHARE = 0.1;
+    static constexpr double MAX_HARD_SHARE = 0.25;
+    static constexpr double HARD_FACTOR = 3;
+    static constexpr double UNSTABLE_FACTOR = 1.6;
+    static constexpr double STABLE_FACTOR = 0.5;
+    static constexpr int STABLE_ITERATIONS = 2;
+    static constexpr double MIN_GROWTH = 2, MAX_GROWTH = 10;
+    static constexpr double MIN_MEASURED_COST = 0.005;
+
+    Clock::time_point begin, last_iteration;
+    double soft = 0, hard = 0, growth = MIN_GROWTH, previous_cost = 0;
+    size_t best = NO_BEST;
+    int stable = 0;
 };
 
-// Static member definitions
-std::array<std::array<std::array<std::array<std::array<uint64_t, 3>, 2>, 2>, ZobristHash::MAX_COLS>, ZobristHash::MAX_ROWS> ZobristHash::zobrist_table;
-uint64_t ZobristHash::player_hash[2];
-bool ZobristHash::initialized = false;
+Board empty_board(int rows, int cols) {
+    Board board(rows, std::vector<std::map<std::string, std::string>>(cols));
+    return board;
+}
 
 // ---- Student Agent Class ----
 
-class StudentAgent {
-public:
-    explicit StudentAgent(const std::string& player) 
-        : player(player), opponent(get_opponent(player)), search_depth(3),fast_depth(3), gen(rd()) {
-        bool set_board = false;
+// Progress of a search started with StudentAgent::start_search.
+struct SearchInfo {
+    bool running = false;
+    Move best_move;     // best move of the deepest finished iteration, or the final choice
+    int depth = 0;      // deepest finished iteration
+    double value = 0;   // its value in evaluation points, from the searching side's view
+    uint64_t nodes = 0; // nodes searched up to that iteration
+    double elapsed = 0; // seconds since start_search
+};
 
-        // Initialize Zobrist table early to avoid first-time overhead
-        ZobristHash::compute_hash(Board{}, "circle", 0, 0);
+// Cache entries shared out between the agents holding the budget: each may fill an equal
+// share, which changes as agents come and go.
+struct CacheBudget {
+    explicit CacheBudget(size_t entries) : entries(entries) {}
+    size_t share() const { return entries / std::max<size_t>(1, holders); }
 
-        // Pre-reserve space for all caches to reduce rehashing
-        tt.reserve(80000);
-        eval_cache.reserve(40000);
-        moves_cache.reserve(40000);
-        board_cache.reserve(80000);
-
-        MoveList mv_list;
-        MoveList mv_list_small;
-        MoveList mv_list_medium;
-        MoveList mv_list_large;
-        if (player == "circle") {
-            // if()
-            mv_list_small= {
-                Move("flip", {8, 9}, {8, 9}, {}, "horizontal"),
-                Move("flip", {3, 9}, {3, 9}, {}, "horizontal"),
-                Move("flip", {3, 8}, {3, 8}, {}, "vertical"),
-                Move("flip", {8, 8}, {8, 8}, {}, "vertical"),
-                Move("move", {8, 8}, {11, 9}),  //right
-                Move("move", {3, 8}, {0, 9}), // left
-                Move("flip", {7, 9}, {7, 9}, {}, "horizontal"),
-                Move("flip", {4, 9}, {4, 9}, {}, "horizontal"),
-            };
-            // medium board  is of 15 rows and 14 cols with a no. of scoring areas of 5. Lets modify the pre moves for medium board
-            mv_list_medium = {
-                Move("flip", {3,11}, {3, 11}, {}, "horizontal"),
-                Move("flip", {9, 11}, {9, 11}, {}, "horizontal"),
-                Move("flip", {3, 10}, {3, 10}, {}, "vertical"),
-                Move("flip", {9, 10}, {9, 10}, {}, "vertical"),
-                Move("move", {3, 10}, {0, 11}),  //right
-                Move("move", {9, 10}, {13, 11}), // left
-                Move("flip", {4, 11}, {4, 11}, {}, "horizontal"),
-                Move("flip", {8, 11}, {8, 11}, {}, "horizontal"),
-
-
-            };
-
-            mv_list_large = {
-                Move("flip", {4,13}, {4, 13}, {}, "horizontal"),
-                Move("flip", {11, 13}, {11, 13}, {}, "horizontal"),
-                Move("flip", {4, 12}, {4, 12}, {}, "vertical"),
-                Move("flip", {11, 12}, {11, 12}, {}, "vertical"),
-                Move("move", {11, 12}, {15, 13}),  //right
-                Move("move", {4, 12}, {0, 13}), // left
-                Move("flip", {5, 13}, {5, 13}, {}, "horizontal"),
-                Move("flip", {10, 13}, {10, 13}, {}, "horizontal"),
-            
-            };
-            // mv_list = mv_list_small; // Default to small board moves
-        }
-         else {
-            mv_list_small = {
-                Move("flip", {8, 3}, {8, 3}, {}, "horizontal"),
-                Move("flip", {3, 3}, {3, 3}, {}, "horizontal"),
-                Move("flip", {8, 4}, {8, 4}, {}, "vertical"),
-                Move("flip", {3, 4}, {3, 4}, {}, "vertical"),
-                Move("move", {8, 4}, {11, 3}),
-                Move("move", {3, 4}, {0, 3}),
-                Move("flip", {4, 3}, {4, 3}, {}, "horizontal"),
-                Move("flip", {7, 3}, {7, 3}, {}, "horizontal"),
-            };
-            mv_list_medium = {
-                Move("flip", {9, 3}, {9, 3}, {}, "horizontal"),
-                Move("flip", {9, 4}, {9, 4}, {}, "vertical"),
-                Move("flip", {3, 3}, {3, 3}, {}, "horizontal"),
-                Move("flip", {3, 4}, {3, 4}, {}, "vertical"),
-                Move("move", {9, 4}, {13, 3}),
-                Move("move", {3, 4}, {0, 3}),
-                Move("flip", {8, 3}, {8, 3}, {}, "horizontal"),
-                Move("flip", {4, 3}, {4, 3}, {}, "horizontal"),
-            };
-            mv_list_large = {
-                Move("flip", {4, 3}, {4, 3}, {}, "horizontal"),
-                Move("flip", {4, 4}, {4, 4}, {}, "vertical"),
-                Move("flip", {11, 3}, {11, 3}, {}, "horizontal"),
-                Move("flip", {11, 4}, {11, 4}, {}, "vertical"),
-                Move("move", {4, 4}, {0, 3}),
-                Move("move", {11, 4}, {15, 3}),
-                Move("flip", {5, 3}, {5, 3}, {}, "horizontal"),
-                Move("flip", {10, 3}, {10, 3}, {}, "horizontal"),
-            };
-        }
-
-        this->mv_list_small = mv_list_small;
-        this->mv_list_medium = mv_list_medium;
-        this->mv_list_large = mv_list_large;
-        this->set_board = set_board;
-        this->mv_list = mv_list;
+    std::atomic<size_t> entries;
+    std::atomic<size_t> holders{0};
+};
+
+// Hash map whose size is checked on every insert against a limit that may change between
+// inserts. A new key that finds the map full takes the place of the first entry in the
+// buckets around its own that `replaceable(old, new)` gives up, and is dropped if none does.
+template <class Value>
+class BoundedCache {
+public:
+    const Value* find(uint64_t key) const {
+        auto it = map.find(key);
+        return it == map.end() ? nullptr : &it->second;
     }
 
-    void set_board_size(int rows, int cols) {
-        MoveList mv_list;
-        if (rows == 13 && cols == 12) { 
+    template <class Replaceable>
+    void store(uint64_t key, const Value& value, size_t limit, Replaceable replaceable) {
+        auto it = map.find(key);
+        if (it != map.end()) { it->second = value; return; }
+        // after the limit drops, each insert gives up to two entries back
+        for (int evicted = 0; map.size() >= limit; ++evicted)
+            if (evicted == 2 || !evict(key, value, replaceable)) return;
+        map.emplace(key, value);
+    }
+
+    void reserve(size_t n) { map.reserve(n); }
+    void clear() { map.clear(); }
+    size_t size() const { return map.size(); }
 
-            this->mv_list = mv_list_small;
-        } else if (rows == 15 && cols == 14) { // Medium board
-            this->mv_list = mv_list_medium;
-        } else if (rows == 17 && cols == 16) { // Large board 
-            this->mv_list = mv_list_large;
-        } 
+private:
+    static constexpr size_t PROBE_BUCKETS = 4;
+
+    template <class Replaceable>
+    bool evict(uint64_t key, const Value& value, Replaceable replaceable) {
+        if (map.empty()) return false;
+        const size_t buckets = map.bucket_count(), first = map.bucket(key);
+        for (size_t k = 0; k < PROBE_BUCKETS; ++k) {
+            const size_t b = (first + k) % buckets;
+            for (auto it = map.begin(b); it != map.end(b); ++it) {
+                if (!replaceable(it->second, value)) continue;
+                const uint64_t victim = it->first;
+                map.erase(victim);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::unordered_map<uint64_t, Value> map;
+};
+
+// One root move of StudentAgent::analyze, with its exact value and principal variation.
+struct AnalysisLine {
+    Move move;
+    double value = 0;      // in evaluation points, from the analysed side's view
+    std::vector<Move> pv;  // starting with move
+};
+
+// Result of StudentAgent::analyze.
+struct Analysis {
+    Move best_move;
+    double value = 0;      // in evaluation points, from the analysed side's view
+    std::vector<Move> pv;  // principal variation, starting with best_move
+    std::vector<AnalysisLine> lines; // the best multipv root moves, best first
+    int depth = 0;         // deepest finished iteration
+    uint64_t nodes = 0;
+    double elapsed = 0;    // seconds
+};
+
+// A search that runs a bounded number of nodes at a time; see StudentAgent::resumable_search.
+class ResumableTask {
+public:
+    virtual ~ResumableTask() = default;
+    // Search up to `nodes` more nodes; true once the value is known.
+    virtual bool step(uint64_t nodes) = 0;
+    virtual bool finished() const = 0;
+    virtual double value() const = 0; // in evaluation points, from the agent's point of view
+};
+
+// A scripted opening move; flips and rotations stay on (fx, fy).
+struct OpeningMove {
+    const char* action;
+    int fx, fy, tx, ty;
+    const char* orientation;
+};
+
+// The opening choose plays for `side` before it starts searching, tried in order; empty on
+// layouts without one.
+inline MoveList opening_line(Side side, int rows, int cols) {
+    using Line = std::array<OpeningMove, 8>;
+    static constexpr Line CIRCLE_SMALL = {{
+        {"flip", 8, 9, 8, 9, "horizontal"},
+        {"flip", 3, 9, 3, 9, "horizontal"},
+        {"flip", 3, 8, 3, 8, "vertical"},
+        {"flip", 8, 8, 8, 8, "vertical"},
+        {"move", 8, 8, 11, 9, ""},  //right
+        {"move", 3, 8, 0, 9, ""}, // left
+        {"flip", 7, 9, 7, 9, "horizontal"},
+        {"flip", 4, 9, 4, 9, "horizontal"},
+    }};
+    static constexpr Line CIRCLE_MEDIUM = {{
+        {"flip", 3, 11, 3, 11, "horizontal"},
+        {"flip", 9, 11, 9, 11, "horizontal"},
+        {"flip", 3, 10, 3, 10, "vertical"},
+        {"flip", 9, 10, 9, 10, "vertical"},
+        {"move", 3, 10, 0, 11, ""},  //right
+        {"move", 9, 10, 13, 11, ""}, // left
+        {"flip", 4, 11, 4, 11, "horizontal"},
+        {"flip", 8, 11, 8, 11, "horizontal"},
+    }};
+    static constexpr Line CIRCLE_LARGE = {{
+        {"flip", 4, 13, 4, 13, "horizontal"},
+        {"flip", 11, 13, 11, 13, "horizontal"},
+        {"flip", 4, 12, 4, 12, "vertical"},
+        {"flip", 11, 12, 11, 12, "vertical"},
+        {"move", 11, 12, 15, 13, ""},  //right
+        {"move", 4, 12, 0, 13, ""}, // left
+        {"flip", 5, 13, 5, 13, "horizontal"},
+        {"flip", 10, 13, 10, 13, "horizontal"},
+    }};
+    static constexpr Line SQUARE_SMALL = {{
+        {"flip", 8, 3, 8, 3, "horizontal"},
+        {"flip", 3, 3, 3, 3, "horizontal"},
+        {"flip", 8, 4, 8, 4, "vertical"},
+        {"flip", 3, 4, 3, 4, "vertical"},
+        {"move", 8, 4, 11, 3, ""},
+        {"move", 3, 4, 0, 3, ""},
+        {"flip", 4, 3, 4, 3, "horizontal"},
+        {"flip", 7, 3, 7, 3, "horizontal"},
+    }};
+    static constexpr Line SQUARE_MEDIUM = {{
+        {"flip", 9, 3, 9, 3, "horizontal"},
+        {"flip", 9, 4, 9, 4, "vertical"},
+        {"flip", 3, 3, 3, 3, "horizontal"},
+        {"flip", 3, 4, 3, 4, "vertical"},
+        {"move", 9, 4, 13, 3, ""},
+        {"move", 3, 4, 0, 3, ""},
+        {"flip", 8, 3, 8, 3, "horizontal"},
+        {"flip", 4, 3, 4, 3, "horizontal"},
+    }};
+    static constexpr Line SQUARE_LARGE = {{
+        {"flip", 4, 3, 4, 3, "horizontal"},
+        {"flip", 4, 4, 4, 4, "vertical"},
+        {"flip", 11, 3, 11, 3, "horizontal"},
+        {"flip", 11, 4, 11, 4, "vertical"},
+        {"move", 4, 4, 0, 3, ""},
+        {"move", 11, 4, 15, 3, ""},
+        {"flip", 5, 3, 5, 3, "horizontal"},
+        {"flip", 10, 3, 10, 3, "horizontal"},
+    }};
+
+    const Line* line = nullptr;
+    if (rows == 13 && cols == 12) line = side == CIRCLE ? &CIRCLE_SMALL : &SQUARE_SMALL;
+    else if (rows == 15 && cols == 14) line = side == CIRCLE ? &CIRCLE_MEDIUM : &SQUARE_MEDIUM;
+    else if (rows == 17 && cols == 16) line = side == CIRCLE ? &CIRCLE_LARGE : &SQUARE_LARGE;
+    MoveList moves;
+    if (!line) return moves;
+    for (const OpeningMove& m : *line)
+        moves.emplace_back(m.action, std::vector<int>{m.fx, m.fy}, std::vector<int>{m.tx, m.ty},
+                           std::vector<int>{}, m.orientation);
+    return moves;
+}
+
+class StudentAgent {
+public:
+    // cache entries of an agent with a budget of its own
+    static constexpr size_t DEFAULT_CACHE_ENTRIES = size_t(1) << 21;
+
+    explicit StudentAgent(const std::string& player, size_t cache_entries = DEFAULT_CACHE_ENTRIES)
+        : StudentAgent(player, std::make_shared<CacheBudget>(cache_entries)) {}
+
+    // An agent drawing on a budget shared with others (see AgentHost).
+    StudentAgent(const std::string& player, std::shared_ptr<CacheBudget> budget)
+        : player(player), side(side_of(player)), search_depth(3), gen(rd()), cache_budget(std::move(budget)) {
+        ++cache_budget->holders;
+
+        // Pre-reserve space for all caches to reduce rehashing
+        const size_t cache_entries = cache_budget->share();
+        tt.reserve(std::min<size_t>(80000, cache_entries));
+        eval_cache.reserve(std::min<size_t>(40000, cache_entries / 2));
+        moves_cache.reserve(std::min<size_t>(40000, cache_entries / 2));
+    }
+
+    ~StudentAgent() {
+        stop();
+        wait();
+        stop_pondering();
+        --cache_budget->holders;
+    }
+
+    void set_board_size(int rows, int cols) {
+        mv_list = opening_line(side, rows, cols);
     }
-    
 
     void recovery_moves(const Board&board,Move failed_move,int rows, int cols, const std::vector<int>& score_cols) {
-        if(player == "circle"){
+        if(side == CIRCLE){
             if(failed_move.action == "move"){
                 if(failed_move.to[0] == 11 && failed_move.to[1] == 9){
                     mv_list = {
@@ -954,7 +1796,7 @@ public:
                 }
             }
         }
-        if(player=="square"){
+        if(side == SQUARE){
             if(failed_move.action == "move"){
                 if(failed_move.to[0] == 11 && failed_move.to[1] == 3){
                     mv_list = {
@@ -1028,7 +1870,6 @@ bool check_move(const Board& board, const Move& mv, const std::string& player,
         Position to = {mv.to[0], mv.to[1]};
         if(board[to.second][to.first].empty()) return false;
         const auto& pc = board[to.second][to.first];
-        cout << "Its not empty" << endl;
         std::string side = pc.at("side");
 
         if (side == "stone") {
@@ -1062,150 +1903,686 @@ bool check_move(const Board& board, const Move& mv, const std::string& player,
     return false;
 }
 
-    double cached_evaluate(const Board& board, int rows, int cols, const std::vector<int>& score_cols) {
-        uint64_t key = ZobristHash::compute_hash(board, player, rows, cols);
-        auto it = eval_cache.find(key);
-        if (it != eval_cache.end()) {
-            return it->second;
+    // Share transposition entries between positions that are mirror images or colour-swapped
+    // copies of each other (see PackedBoard::canonical_key).
+    void set_symmetric_keys(bool on) {
+        stop_pondering();
+        if (on != symmetric_keys) tt.clear();
+        symmetric_keys = on;
+    }
+
+    // Transposition key of a position with `stm` to move; `sym` maps it onto the position
+    // the key was made for, and moves stored under it have to be mapped back with it.
+    template <class G>
+    uint64_t tt_key(const PackedBoard<G>& board, Side stm, Symmetry& sym) const {
+        if (symmetric_keys) return board.canonical_key_for(stm, sym);
+        sym = SYM_IDENTITY;
+        return board.key_for(stm);
+    }
+    template <class G>
+    uint64_t child_tt_key(const PackedBoard<G>& board, const PackedMove& move, Side stm) const {
+        if (!symmetric_keys) return packed_child_key(board, move) ^ G::ZOBRIST_SIDE[stm];
+        PackedBoard<G> child = board;
+        apply_packed_move(child, move);
+        Symmetry sym;
+        return child.canonical_key_for(stm, sym);
+    }
+
+    // The cache holds circle's view; the evaluation is antisymmetric so one entry serves both sides.
+    // Only exact values are cached; a lazy bound outside [alpha, beta] is returned as is.
+    template <class G, Side S>
+    Score cached_evaluate(const PackedBoard<G>& board, Score alpha = -SCORE_INF, Score beta = SCORE_INF) {
+        if (const Score* cached = eval_cache.find(board.key)) {
+            return S == CIRCLE ? *cached : -*cached;
         }
-        double score = basic_evaluate_board(board, player, rows, cols, score_cols);
-        eval_cache[key] = score;
+        bool exact;
+        Score score = evaluate_window<G, S>(board, alpha, beta, exact, &eval_caches);
+        if (exact)
+            eval_cache.store(board.key, S == CIRCLE ? score : -score, cache_budget->share() / 2,
+                             [](Score, Score) { return true; });
         return score;
     }
     
-    MoveList cached_generate_moves(const Board& board, const std::string& current_player, int rows, int cols, const std::vector<int>& score_cols, bool do_order = true) {
-        uint64_t base_hash = ZobristHash::compute_hash(board, current_player, rows, cols);
-        uint64_t key = base_hash ^ (do_order ? 0x123456789ABCDEF0ULL : 0xFEDCBA9876543210ULL);
-        auto cache_it = moves_cache.find(key);
-        if (cache_it != moves_cache.end()) {
-            return cache_it->second;
-        }
-        MoveList moves = generate_all_moves(board, current_player, rows, cols, score_cols);
+    // Lists are shared with the nodes using them, so the cache can drop one while a search
+    // still walks it. Bounded to a quarter of the agent's share of the cache budget.
+    template <class G, Side Stm>
+    std::shared_ptr<const PackedMoveList> cached_generate_moves(const PackedBoard<G>& board, bool do_order = true) {
+        uint64_t key = board.key_for(Stm) ^ (do_order ? 0x123456789ABCDEF0ULL : 0xFEDCBA9876543210ULL);
+        if (const auto* cached = moves_cache.find(key)) {
+            return *cached;
+        }
+        PackedMoveList moves;
+        generate_packed_moves<G, Stm>(board, moves);
         if (do_order) {
-            moves = order_moves(board, moves, current_player, rows, cols, score_cols);
+            moves = order_moves<G, Stm>(board, moves, &eval_caches);
         }
-        moves_cache[key] = moves;
-        return moves;
+        auto shared = std::make_shared<const PackedMoveList>(std::move(moves));
+        moves_cache.store(key, shared, cache_budget->share() / 4, [](const auto&, const auto&) { return true; });
+        return shared;
     }
-    
-    Board cached_simulate(const Board& board, const Move& move, const std::string& current_player, int rows, int cols, const std::vector<int>& score_cols) {
-        uint64_t base_hash = ZobristHash::compute_hash(board, current_player, rows, cols);
-        uint64_t move_hash = 0;
-        if (!move.from.empty() && move.from.size() >= 2) {
-            move_hash ^= (static_cast<uint64_t>(move.from[0]) << 32) | move.from[1];
+
+    // Mate scores are stored relative to the node so they stay valid at any ply.
+    static Score score_to_tt(Score s, int ply) {
+        return s >= MATE_BOUND ? s + ply : s <= -MATE_BOUND ? s - ply : s;
+    }
+    static Score score_from_tt(Score s, int ply) {
+        return s >= MATE_BOUND ? s - ply : s <= -MATE_BOUND ? s + ply : s;
+    }
+
+    // Search past the horizon on scoring moves only. A side facing a completing move
+    // gets no stand-pat and answers with all its moves instead, which extends the
+    // search on threats; out of quiescence depth, the static value is returned.
+    template <class G, Side Stm>
+    Score quiesce(const PackedBoard<G>& board, Score alpha, Score beta, int ply, int qdepth) {
+        constexpr Side next = other_side(Stm);
+        if (packed_scoring_count<G, next>(board) == G::SCORE_W) return -(MATE - ply);
+        if (packed_scoring_count<G, Stm>(board) == G::SCORE_W) return MATE - ply;
+        if (has_winning_move<G, Stm>(board)) return MATE - ply - 1;
+
+        bool threatened = has_winning_move<G, next>(board);
+        PackedMoveList moves;
+        if (threatened && qdepth > 0) {
+            generate_packed_moves<G, Stm>(board, moves);
+            if (moves.empty()) return 0;
+            Score best = -SCORE_INF;
+            for (const auto& move : moves) {
+                PackedBoard<G> child = board;
+                apply_packed_move(child, move);
+                best = std::max(best, -quiesce<G, next>(child, -beta, -alpha, ply + 1, qdepth - 1));
+                alpha = std::max(alpha, best);
+                if (alpha >= beta) break;
+            }
+            return best;
         }
-        if (!move.to.empty() && move.to.size() >= 2) {
-            move_hash ^= (static_cast<uint64_t>(move.to[0]) << 16) | move.to[1];
+
+        Score best = cached_evaluate<G, Stm>(board, alpha, beta);
+        if (threatened || qdepth == 0 || best >= beta) return best;
+        alpha = std::max(alpha, best);
+        scoring_moves<G, Stm>(board, moves);
+        for (const auto& move : moves) {
+            if (scoring_delta<G, Stm>(board, move) <= 0) continue;
+            PackedBoard<G> child = board;
+            apply_packed_move(child, move);
+            best = std::max(best, -quiesce<G, next>(child, -beta, -alpha, ply + 1, qdepth - 1));
+            alpha = std::max(alpha, best);
+            if (alpha >= beta) break;
         }
-        for (char c : move.action) {
-            move_hash = (move_hash << 5) ^ static_cast<uint64_t>(c);
+        return best;
+    }
+
+    bool stopped() const {
+        return stop_requested.load(std::memory_order_relaxed) || search_stop.load(std::memory_order_relaxed);
+    }
+
+    // Raises the stop flag once a timed search passes its deadline; the clock is read every
+    // DEADLINE_CHECK_NODES nodes.
+    bool out_of_time() {
+        if (++search_nodes & (DEADLINE_CHECK_NODES - 1) || !timed_search) return false;
+        if (TimeManager::Clock::now() < search_deadline) return false;
+        stop_requested = true;
+        return true;
+    }
+
+    // Ponder mode: once choose has answered, a background thread searches the position our
+    // reply leaves, with every opponent move, deeper and deeper into the shared
+    // transposition table until the next call interrupts it.
+    void set_ponder(bool on) {
+        if (!on) stop_pondering();
+        ponder_enabled = on;
+    }
+
+    void stop_pondering() {
+        if (!ponder_thread.joinable()) return;
+        stop_requested = true;
+        ponder_thread.join();
+        stop_requested = false;
+    }
+
+    // Non-blocking search: start_search runs choose on a native thread and returns at once.
+    // poll reports the best move of the deepest finished iteration so far, stop ends the
+    // search early, and wait returns the move it settled on. choose, analyze, alphabeta and
+    // resumable_search throw std::logic_error until the search is over, and start_search
+    // throws while a resumable search holds the agent.
+    void start_search(const Board& board, int rows, int cols, const std::vector<int>& score_cols, float current_player_time, float opponent_time) {
+        begin_search();
+        search_thread = std::thread([this, board, rows, cols, score_cols, current_player_time, opponent_time] {
+            run_search(board, rows, cols, score_cols, current_player_time, opponent_time);
+        });
+    }
+
+    // The two halves of start_search, for hosts that run the search on a thread of their
+    // own: begin_search marks a search as pending, run_search carries it out. Time spent
+    // between the two is taken off our clock.
+    void begin_search() {
+        if (resumable_owned) throw std::logic_error("start_search: a resumable search holds the agent");
+        stop();
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(search_info_mutex);
+            search_info = SearchInfo{};
+            search_info.running = true;
         }
-        uint64_t key = base_hash ^ move_hash;
-        
-        auto it = board_cache.find(key);
-        if (it != board_cache.end()) {
-            return it->second;
+        search_started = TimeManager::Clock::now();
+        search_stop = false;
+    }
+
+    void run_search(const Board& board, int rows, int cols, const std::vector<int>& score_cols, float current_player_time, float opponent_time) {
+        float queued = float(seconds_since(search_started));
+        Move mv = choose_move(board, rows, cols, score_cols, std::max(0.f, current_player_time - queued), opponent_time);
+        {
+            std::lock_guard<std::mutex> lock(search_info_mutex);
+            search_info.best_move = mv;
+            search_info.running = false;
+            search_info.elapsed = seconds_since(search_started);
         }
-        Board new_board = simulate_move_cpp(board, move, current_player, rows, cols, score_cols);
-        board_cache[key] = new_board;
-        return new_board;
+        search_done.notify_all();
     }
 
-    double alphabeta(const Board& board, int depth, double alpha, double beta, bool maximizing_player, int rows, int cols, const std::vector<int>& score_cols) {
-        std::string current_player = maximizing_player ? player : opponent;
-        double score_check = cached_evaluate(board, rows, cols, score_cols);
-        if (std::abs(score_check) == 10000 || depth == 0) {
-            return score_check;
+    SearchInfo poll() {
+        std::lock_guard<std::mutex> lock(search_info_mutex);
+        SearchInfo info = search_info;
+        if (info.running) info.elapsed = seconds_since(search_started);
+        return info;
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(search_info_mutex);
+        if (search_info.running) search_stop = true;
+    }
+
+    Move wait() {
+        if (search_thread.joinable()) search_thread.join();
+        std::unique_lock<std::mutex> lock(search_info_mutex);
+        search_done.wait(lock, [this] { return !search_info.running; });
+        search_stop = false;
+        return search_info.best_move;
+    }
+
+    // Whether a position (key_for the side to move) already occurred on the current search
+    // path or in the game. The path is a handful of keys, so a linear scan is enough.
+    bool repeated(uint64_t position) const {
+        return std::find(path_keys.begin(), path_keys.end(), position) != path_keys.end() ||
+               game_keys.count(position);
+    }
+
+    // Value of a repetition for this agent, in evaluation points; the opponent sees its negation.
+    void set_draw_score(double points) {
+        stop_pondering();
+        draw_score = from_points(points);
+    }
+
+    // One negamax node between entering and leaving it. The board stays with the caller,
+    // so the recursive search keeps it on the call stack and ResumableSearch in its frames.
+    struct Node {
+        int depth = 0, ply = 0;
+        Score alpha = -SCORE_INF, beta = SCORE_INF;
+        Score alpha_orig = 0, best = -SCORE_INF;
+        uint64_t key = 0, position = 0;
+        Symmetry sym = SYM_IDENTITY;
+        PackedMove tt_move{}, best_move{}, current{};
+        bool has_tt_move = false;
+        bool path_dependent = false;                   // a value below came from a repetition
+        std::shared_ptr<const PackedMoveList> moves{}; // shared with moves_cache
+        int next = 0;                                  // next entry of moves; -1 is the table move
+    };
+
+    // Everything negamax does at a node before its move loop. True if that decides the
+    // node, with its value (from Stm's point of view) in `value`.
+    template <class G, Side Stm>
+    bool enter_node(const PackedBoard<G>& board, Node& n, Score& value) {
+        constexpr Side next = other_side(Stm);
+        path_dependent = false;
+        // an interrupted search unwinds without storing anything; callers discard its value
+        if (stopped() || out_of_time()) { value = 0; return true; }
+
+        // a completed scoring row ends the game
+        if (packed_scoring_count<G, next>(board) == G::SCORE_W) { value = -(MATE - n.ply); return true; }
+        if (packed_scoring_count<G, Stm>(board) == G::SCORE_W) { value = MATE - n.ply; return true; }
+        // shuffling back to a position of this line or of the game so far is a draw
+        n.position = board.key_for(Stm);
+        // (such a value depends on the line, so it and the nodes above it stay out of tt)
+        if (n.ply > 0 && repeated(n.position)) {
+            value = Stm == side ? draw_score : -draw_score;
+            path_dependent = true;
+            return true;
         }
-        uint64_t key = ZobristHash::compute_hash(board, current_player, rows, cols);
-        auto it = tt.find(key);
-        if (it != tt.end() && it->second.depth >= depth && it->second.has_value) {
-            return it->second.value;
+        if (n.depth == 0) { value = quiesce<G, Stm>(board, n.alpha, n.beta, n.ply, QUIESCE_DEPTH); return true; }
+        // replies that leave a completing move on the board end here, so lines that
+        // ignore a threat cost one detector call instead of a subtree
+        if (has_winning_move<G, Stm>(board)) { value = MATE - n.ply - 1; return true; }
+
+        // no line from here can beat a faster mate already found
+        n.alpha = std::max(n.alpha, -(MATE - n.ply));
+        n.beta = std::min(n.beta, MATE - n.ply - 1);
+        if (n.alpha >= n.beta) { value = n.alpha; return true; }
+
+        n.key = tt_key(board, Stm, n.sym);
+        if (const TTEntry* entry = tt.find(n.key)) {
+            const TTEntry& e = *entry;
+            n.tt_move = transform_move<G>(e.move, n.sym);
+            if (e.depth >= n.depth) {
+                Score v = score_from_tt(e.value, n.ply);
+                if (e.bound == BOUND_EXACT || (e.bound == BOUND_LOWER && v >= n.beta) ||
+                    (e.bound == BOUND_UPPER && v <= n.alpha)) {
+                    value = v;
+                    return true;
+                }
+            }
         }
 
-        auto moves = cached_generate_moves(board, current_player, rows, cols, score_cols);
-        if (moves.empty()) {
-            return 0;
-        }
+        n.moves = cached_generate_moves<G, Stm>(board);
+        const PackedMoveList& moves = *n.moves;
+        if (moves.empty()) { value = 0; return true; }
 
-        if (maximizing_player) {
-            double max_eval = -std::numeric_limits<double>::infinity();
+        // Enhanced transposition cutoff: a child the table already scores at or above beta
+        // refutes this node without searching anything
+        if (n.depth >= 2) {
             for (const auto& move : moves) {
-                Board new_board = cached_simulate(board, move, current_player, rows, cols, score_cols);
-                double eval = alphabeta(new_board, depth - 1, alpha, beta, false, rows, cols, score_cols);
-                max_eval = std::max(max_eval, eval);
-                alpha = std::max(alpha, eval);
-                if (beta <= alpha) {
-                    break;
+                const TTEntry* ct = tt.find(child_tt_key(board, move, next));
+                if (!ct || ct->depth < n.depth - 1 || ct->bound == BOUND_LOWER) continue;
+                Score v = -score_from_tt(ct->value, n.ply + 1);
+                if (v >= n.beta) {
+                    tt_store(n.key, {score_to_tt(v, n.ply), int8_t(n.depth), BOUND_LOWER, transform_move<G>(move, n.sym), tt_generation});
+                    value = v;
+                    return true;
                 }
-                if(eval > 1e6){
-                    search_depth = 1;
-                }
-                else{
-                    search_depth = fast_depth;
+            }
+        }
+
+        // try the table move first, then the evaluation order
+        n.has_tt_move = n.tt_move.from != NO_CELL &&
+                        std::find(moves.begin(), moves.end(), n.tt_move) != moves.end();
+        n.next = n.has_tt_move ? -1 : 0;
+        n.alpha_orig = n.alpha;
+        n.best_move = moves[0];
+        return false;
+    }
+
+    // The next move of a node's loop, which becomes its current move.
+    static bool next_move(Node& n) {
+        while (n.next < (int)n.moves->size()) {
+            int k = n.next++;
+            if (k < 0) { n.current = n.tt_move; return true; }
+            if (n.has_tt_move && (*n.moves)[k] == n.tt_move) continue;
+            n.current = (*n.moves)[k];
+            return true;
+        }
+        return false;
+    }
+
+    // Take the value of the current move, as the child left path_dependent; true on a beta
+    // cutoff.
+    bool update_node(Node& n, Score eval) {
+        n.path_dependent |= path_dependent;
+        if (eval > n.best) { n.best = eval; n.best_move = n.current; }
+        n.alpha = std::max(n.alpha, eval);
+        return n.alpha >= n.beta;
+    }
+
+    // Store a node whose loop has ended and return its value.
+    template <class G>
+    Score leave_node(const Node& n) {
+        path_dependent = n.path_dependent;
+        if (n.path_dependent) return n.best;
+        Bound bound = n.best <= n.alpha_orig ? BOUND_UPPER : n.best >= n.beta ? BOUND_LOWER : BOUND_EXACT;
+        tt_store(n.key, {score_to_tt(n.best, n.ply), int8_t(n.depth), bound, transform_move<G>(n.best_move, n.sym), tt_generation});
+        return n.best;
+    }
+
+    // negamax with its recursion in an explicit stack of frames, one per open node of the
+    // current line, so the search can stop after any node and carry on later. Each step
+    // enters one node; the value is the same as negamax's.
+    template <class G>
+    class ResumableSearch : public ResumableTask {
+    public:
+        ResumableSearch(StudentAgent& agent, const PackedBoard<G>& root, Side stm, int depth, bool negate)
+            : agent(agent), negate(negate) {
+            agent.path_keys.clear();
+            enter(root, stm, depth, -SCORE_INF, SCORE_INF, 0);
+            agent.resumable_owned = true;
+        }
+        ~ResumableSearch() override { agent.resumable_owned = false; }
+
+        bool step(uint64_t nodes) override {
+            for (uint64_t k = 0; k < nodes && !done; ++k) advance();
+            return done;
+        }
+        bool finished() const override { return done; }
+        double value() const override { return to_points(negate ? -result : result); }
+
+    private:
+        struct Frame {
+            PackedBoard<G> board;
+            Side stm;
+            Node node;
+        };
+
+        // search the next move of the deepest open node, or close it
+        void advance() {
+            Frame& f = stack.back();
+            if (agent.stopped() || !next_move(f.node)) { leave(); return; }
+            PackedBoard<G> child = f.board;
+            apply_packed_move(child, f.node.current);
+            enter(child, other_side(f.stm), f.node.depth - 1, -f.node.beta, -f.node.alpha, f.node.ply + 1);
+        }
+
+        void enter(const PackedBoard<G>& board, Side stm, int depth, Score alpha, Score beta, int ply) {
+            Node n{depth, ply, alpha, beta};
+            Score value;
+            bool decided = stm == CIRCLE ? agent.enter_node<G, CIRCLE>(board, n, value)
+                                         : agent.enter_node<G, SQUARE>(board, n, value);
+            if (decided) { deliver(value); return; }
+            agent.path_keys.push_back(n.position);
+            stack.push_back({board, stm, n});
+        }
+
+        void leave() {
+            agent.path_keys.pop_back();
+            Score value = agent.stopped() ? 0 : agent.leave_node<G>(stack.back().node);
+            stack.pop_back();
+            deliver(value);
+        }
+
+        // hand the value of a decided node to its parent
+        void deliver(Score value) {
+            if (stack.empty()) { result = value; done = true; return; }
+            if (agent.stopped() || agent.update_node(stack.back().node, -value)) leave();
+        }
+
+        StudentAgent& agent;
+        bool negate;
+        std::vector<Frame> stack;
+        Score result = 0;
+        bool done = false;
+    };
+
+    // Negamax alpha-beta; the result is from the point of view of Stm, the side to move.
+    template <class G, Side Stm>
+    Score negamax(const PackedBoard<G>& board, int depth, Score alpha, Score beta, int ply) {
+        Node n{depth, ply, alpha, beta};
+        Score value;
+        if (enter_node<G, Stm>(board, n, value)) return value;
+        path_keys.push_back(n.position);
+        while (next_move(n)) {
+            PackedBoard<G> new_board = board;
+            apply_packed_move(new_board, n.current);
+            Score eval = -negamax<G, other_side(Stm)>(new_board, depth - 1, -n.beta, -n.alpha, ply + 1);
+            if (stopped()) break;
+            if (update_node(n, eval)) break;
+        }
+        path_keys.pop_back();
+        if (stopped()) return 0;
+        return leave_node<G>(n);
+    }
+
+    // Python-facing search: value in evaluation points from this agent's point of view.
+    double alphabeta(const Board& board, int depth, double alpha, double beta, bool maximizing_player, int rows, int cols, const std::vector<int>& score_cols) {
+        require_idle("alphabeta");
+        return with_geometry(rows, cols, score_cols, [&](auto geometry) {
+            using G = decltype(geometry);
+            return with_side(side, [&](auto us) {
+                constexpr Side Us = decltype(us)::value;
+                stop_pondering();
+                PackedBoard<G> packed = pack_board<G>(board);
+                path_keys.clear();
+                Score a = from_points(alpha), b = from_points(beta);
+                Score v = maximizing_player ? negamax<G, Us>(packed, depth, a, b, 0)
+                                            : -negamax<G, other_side(Us)>(packed, depth, -b, -a, 0);
+                return to_points(v);
+            });
+        });
+    }
+
+    // The search alphabeta runs, as a task for a SearchExecutor. The agent's tables and
+    // search path belong to the task until it is dropped; until then the agent's other
+    // searches throw std::logic_error.
+    std::unique_ptr<ResumableTask> resumable_search(const Board& board, int depth, bool maximizing_player, int rows, int cols, const std::vector<int>& score_cols) {
+        require_idle("resumable_search");
+        return with_geometry(rows, cols, score_cols, [&](auto geometry) -> std::unique_ptr<ResumableTask> {
+            using G = decltype(geometry);
+            stop_pondering();
+            Side stm = maximizing_player ? side : other_side(side);
+            return std::make_unique<ResumableSearch<G>>(*this, pack_board<G>(board), stm, depth, !maximizing_player);
+        });
+    }
+
+    // Audit search of a position with this agent to move: iterative deepening to `depth`,
+    // or until `seconds` have passed if that is positive, without the opening book, the
+    // clock or the proof-number checks of choose. The game history is left as it is. With
+    // multipv above 1, that many root moves get exact values and lines of their own.
+    Analysis analyze(const Board& board, int rows, int cols, const std::vector<int>& score_cols, int depth, double seconds, int multipv = 1) {
+        require_idle("analyze");
+        return with_geometry(rows, cols, score_cols, [&](auto geometry) {
+            return with_side(side, [&](auto us) {
+                using G = decltype(geometry);
+                stop_pondering();
+                return analyze_impl<G, decltype(us)::value>(pack_board<G>(board), depth, seconds, multipv);
+            });
+        });
+    }
+
+    Move choose(const Board& board, int rows, int cols, const std::vector<int>& score_cols, float current_player_time, float opponent_time) {
+        require_idle("choose");
+        return choose_move(board, rows, cols, score_cols, current_player_time, opponent_time);
+    }
+
+private:
+    // Entry points that search with the agent's tables call this first: a ResumableSearch
+    // holds them while it exists, a search started with start_search until it is over.
+    void require_idle(const char* call) {
+        if (resumable_owned) throw std::logic_error(std::string(call) + ": a resumable search holds the agent");
+        std::lock_guard<std::mutex> lock(search_info_mutex);
+        if (search_info.running)
+            throw std::logic_error(std::string(call) + ": a search started with start_search is still running");
+    }
+
+    Move choose_move(const Board& board, int rows, int cols, const std::vector<int>& score_cols, float current_player_time, float opponent_time) {
+        return with_geometry(rows, cols, score_cols, [&](auto geometry) {
+            return with_side(side, [&](auto us) {
+                using G = decltype(geometry);
+                constexpr Side Us = decltype(us)::value;
+                // both the position we were given and the one our reply leaves join the
+                // game history, so the search sees repetitions of either
+                stop_pondering();
+                PackedBoard<G> root = pack_board<G>(board);
+                // one opponent move after our last reply, the table still describes the
+                // tree we are in; anything else is a different game and starts afresh
+                if (expected_roots.count(root.key)) { age_tables(); ++moves_played; }
+                else { tt.clear(); game_keys.clear(); moves_played = 0; }
+                expected_roots.clear();
+                game_keys.insert(root.key_for(Us));
+                Move mv = choose_impl<G, Us>(board, score_cols, current_player_time, opponent_time);
+                search_stop = false;
+                PackedMove reply = from_move<G>(mv);
+                if (reply.from != NO_CELL && cell::owned_by(root.cells[reply.from], Us)) {
+                    apply_packed_move(root, reply);
+                    game_keys.insert(root.key_for(other_side(Us)));
+                    PackedMoveList replies;
+                    generate_packed_moves<G, other_side(Us)>(root, replies);
+                    for (const auto& m : replies) expected_roots.insert(packed_child_key(root, m));
+                    if (ponder_enabled)
+                        ponder_thread = std::thread([this, root] { ponder<G, other_side(Us)>(root); });
                 }
+                return mv;
+            });
+        });
+    }
+
+    // Iterative deepening from a position with Stm (the opponent) to move; each finished
+    // iteration leaves its results in tt for the next choose.
+    template <class G, Side Stm>
+    void ponder(PackedBoard<G> root) {
+        path_keys.clear();
+        for (int depth = 1; depth <= PONDER_MAX_DEPTH && !stopped(); ++depth)
+            negamax<G, Stm>(root, depth, -SCORE_INF, SCORE_INF, 0);
+    }
+
+    // Start a new search generation. Entries from earlier turns stay usable until new ones
+    // need their room (see tt_store).
+    void age_tables() {
+        ++tt_generation;
+    }
+
+    // Multi-PV iterative deepening: the root moves are searched one by one, each with a
+    // window that opens just above the multipv-th best exact value of the iteration so far.
+    // A move that beats it gets an exact value, one that fails low cannot be among the best,
+    // so the best multipv moves come out exact for little more than a single search.
+    template <class G, Side Us>
+    Analysis analyze_impl(const PackedBoard<G>& root, int max_depth, double seconds, int multipv) {
+        constexpr Side Them = other_side(Us);
+        const auto started = TimeManager::Clock::now();
+        path_keys.assign(1, root.key_for(Us));
+        timed_search = seconds > 0;
+        if (timed_search) {
+            search_deadline = started + std::chrono::duration_cast<TimeManager::Clock::duration>(std::chrono::duration<double>(seconds));
+            max_depth = MAX_SEARCH_DEPTH;
+        }
+        search_nodes = 0;
+        Analysis result;
+        const PackedMoveList moves = *cached_generate_moves<G, Us>(root);
+        std::vector<PackedBoard<G>> children(moves.size(), root);
+        for (size_t i = 0; i < moves.size(); ++i) apply_packed_move(children[i], moves[i]);
+        std::vector<size_t> order(moves.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return cached_evaluate<G, Us>(children[a]) > cached_evaluate<G, Us>(children[b]);
+        });
+        const size_t lines = std::min<size_t>(std::max(multipv, 1), moves.size());
+
+        // values of the deepest finished iteration; bounds are upper bounds
+        std::vector<Score> values(moves.size());
+        std::vector<char> exact(moves.size());
+        for (int depth = 1; depth <= std::min(max_depth, MAX_SEARCH_DEPTH) && lines > 0; ++depth) {
+            std::vector<Score> iteration_values(moves.size());
+            std::vector<char> iteration_exact(moves.size());
+            std::vector<Score> best; // exact values of this iteration, highest first
+            for (size_t i : order) {
+                Score alpha = best.size() >= lines ? best[lines - 1] : -SCORE_INF;
+                Score v = -negamax<G, Them>(children[i], depth - 1, -SCORE_INF, -alpha, 1);
+                if (stopped()) break;
+                iteration_values[i] = v;
+                iteration_exact[i] = v > alpha;
+                if (v > alpha) best.insert(std::upper_bound(best.begin(), best.end(), v, std::greater<Score>()), v);
             }
-            tt[key] = {max_eval, depth, true};
-            return max_eval;
+            if (stopped()) break;
+            values.swap(iteration_values);
+            exact.swap(iteration_exact);
+            result.depth = depth;
+            // an upper bound equal to an exact value is no better than it
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                return values[a] != values[b] ? values[a] > values[b] : exact[a] > exact[b];
+            });
+            if (std::all_of(order.begin(), order.begin() + lines, [&](size_t i) { return std::abs(values[i]) >= MATE_BOUND; })) break;
+        }
+        timed_search = false;
+        stop_requested = false;
+        result.nodes = search_nodes;
+
+        if (result.depth == 0) {
+            // not even the first iteration finished; the evaluation order has to do
+            if (!order.empty()) result.best_move = to_move<G>(moves[order[0]]);
         } else {
-            double min_eval = std::numeric_limits<double>::infinity();
-            for (const auto& move : moves) {
-                Board new_board = cached_simulate(board, move, current_player, rows, cols, score_cols);
-                double eval = alphabeta(new_board, depth - 1, alpha, beta, true, rows, cols, score_cols);
-                min_eval = std::min(min_eval, eval);
-                beta = std::min(beta, eval);
-                if (beta <= alpha) {
-                    break;
-                }
+            for (size_t k = 0; k < lines; ++k) {
+                size_t i = order[k];
+                PackedMoveList line{moves[i]};
+                std::vector<uint64_t> seen = path_keys;
+                principal_variation<G, Them>(children[i], result.depth - 1, line, seen);
+                AnalysisLine al;
+                al.move = to_move<G>(moves[i]);
+                al.value = to_points(values[i]);
+                for (const auto& m : line) al.pv.push_back(to_move<G>(m));
+                result.lines.push_back(std::move(al));
             }
-            tt[key] = {min_eval, depth, true};
-            return min_eval;
+            result.best_move = result.lines[0].move;
+            result.value = result.lines[0].value;
+            result.pv = result.lines[0].pv;
+        }
+        result.elapsed = seconds_since(started);
+        return result;
+    }
+
+    // The line the table holds from `board`, up to `length` moves: the stored move of each
+    // position while it is legal, or else a move that completes the scoring row, since the
+    // search decides those nodes without storing them. Ends early at the end of the game or
+    // on a position the line already passed through.
+    template <class G, Side Stm>
+    void principal_variation(PackedBoard<G> board, int length, PackedMoveList& line, std::vector<uint64_t>& seen) {
+        if (length <= 0 || packed_scoring_count<G, other_side(Stm)>(board) == G::SCORE_W) return;
+        uint64_t position = board.key_for(Stm);
+        if (std::find(seen.begin(), seen.end(), position) != seen.end()) return;
+        seen.push_back(position);
+        const auto shared_moves = cached_generate_moves<G, Stm>(board);
+        const PackedMoveList& moves = *shared_moves;
+        Symmetry sym;
+        const TTEntry* entry = tt.find(tt_key(board, Stm, sym));
+        auto pick = moves.end();
+        if (entry) pick = std::find(moves.begin(), moves.end(), transform_move<G>(entry->move, sym));
+        if (pick == moves.end()) {
+            pick = std::find_if(moves.begin(), moves.end(), [&](const PackedMove& m) {
+                PackedBoard<G> child = board;
+                apply_packed_move(child, m);
+                return packed_scoring_count<G, Stm>(child) == G::SCORE_W;
+            });
         }
+        if (pick == moves.end()) return;
+        PackedMove move = *pick;
+        line.push_back(move);
+        apply_packed_move(board, move);
+        principal_variation<G, other_side(Stm)>(board, length - 1, line, seen);
     }
 
-    Move choose(const Board& board, int rows, int cols, const std::vector<int>& score_cols, float current_player_time, float opponent_time) {
-        auto moves = generate_all_moves(board, player, rows, cols, score_cols);
-        cout << "search depth" <<  search_depth << endl;
-        
-        moves = order_moves(board, moves, player, rows, cols, score_cols);
+    void publish_iteration(const Move& best, int depth, Score value) {
+        std::lock_guard<std::mutex> lock(search_info_mutex);
+        search_info.best_move = best;
+        search_info.depth = depth;
+        search_info.value = to_points(value);
+        search_info.nodes = search_nodes;
+    }
+
+    static double seconds_since(TimeManager::Clock::time_point t) {
+        return std::chrono::duration<double>(TimeManager::Clock::now() - t).count();
+    }
+
+    template <class G, Side Us>
+    Move choose_impl(const Board& board, const std::vector<int>& score_cols, float current_player_time, float opponent_time) {
+        constexpr Side Them = other_side(Us);
+        const int rows = G::ROWS, cols = G::COLS;
+        const PackedBoard<G> root = pack_board<G>(board);
+        path_keys.assign(1, root.key_for(Us));
+        PackedMoveList moves;
+        generate_packed_moves<G, Us>(root, moves);
+        moves = order_moves<G, Us>(root, moves, &eval_caches);
         if(!set_board){
             set_board_size(rows,cols);
             set_board = true;
         };
-        cout << "value of current board" << basic_evaluate_board(board, player, rows, cols, score_cols) << endl;
 
-
-        double alpha = -std::numeric_limits<double>::infinity();
-        double beta = std::numeric_limits<double>::infinity();
-        double best_value = -std::numeric_limits<double>::infinity();
+        Score alpha = -SCORE_INF;
+        Score best_value = -SCORE_INF;
         
         if (moves.empty()) {
             return Move("move", {0, 0}, {0, 0});
         }
-        std::vector<Board> child_boards;
+        // Near the end of the game a forced win is proved rather than searched for
+        if (G::SCORE_W - packed_scoring_count<G, Us>(root) <= PROOF_TRIGGER) {
+            ProofNumberSearch<G, Us> pns;
+            if (pns.solve(root, PROOF_NODES) == ProofResult::PROVEN) {
+                return to_move<G>(pns.winning_line(root)[0]);
+            }
+        }
+        std::vector<PackedBoard<G>> child_boards;
         child_boards.reserve(moves.size());
         for (const auto& m : moves) {
-            child_boards.push_back(cached_simulate(board, m, player, rows, cols, score_cols));
+            child_boards.push_back(root);
+            apply_packed_move(child_boards.back(), m);
         }
+        // value of a root child from our point of view
+        auto child_value = [&](const PackedBoard<G>& child, int depth, Score a) {
+            return -negamax<G, Them>(child, depth, -SCORE_INF, -a, 1);
+        };
         int depth = 3;
-        if(rows == 13 && cols == 12 && current_player_time < 15){
-            int depth = 2;
-            fast_depth = 2;
-            search_depth = fast_depth;
-        }
-        else if (rows == 15 && cols == 14 && current_player_time < 20){
-            int depth = 2;
-            fast_depth = 2;
-            search_depth = fast_depth;
-        }
-        else if (rows == 17 && cols == 16 && current_player_time < 25){
-            int depth = 2;
-            fast_depth = 2;
-            search_depth = fast_depth;
-        }
         if (!mv_list.empty()) {
             Move mv = mv_list.front();
-            cout << "move " << mv.action << mv.from[0] << mv.from[1] << mv.to[0] << mv.to[1] << endl;
             mv_list.erase(mv_list.begin());
             
             if (true) {
@@ -1221,18 +2598,14 @@ bool check_move(const Board& board, const Move& mv, const std::string& player,
                     }
                 }
                 if(success){
-                Board new_board = cached_simulate(board, mv, player, rows, cols, score_cols);
-                double board_value = alphabeta(new_board, 2, alpha, beta, false, rows, cols, score_cols);
-                cout << "Success : " << success << endl;
-                cout << "The board value: " << board_value << endl;
-                if (board_value < -100) {
+                PackedBoard<G> new_board = root;
+                apply_packed_move(new_board, from_move<G>(mv));
+                Score board_value = child_value(new_board, 2, alpha);
+                if (board_value < -100 * EVAL_SCALE) {
                     best_value = board_value;
-
-                    cout << "Value below 100" << endl;
                     for (size_t i = 0; i < moves.size(); ++i) {
-                        const Board& new_board_cached = child_boards[i];
-                        double bv = alphabeta(new_board_cached, depth - 1, alpha, beta, false, rows, cols, score_cols);
-                        if (bv > best_value) { best_value = bv; mv = moves[i]; }
+                        Score bv = child_value(child_boards[i], depth - 1, alpha);
+                        if (bv > best_value) { best_value = bv; mv = to_move<G>(moves[i]); }
                     }
                     return mv;
                 }
@@ -1248,62 +2621,426 @@ bool check_move(const Board& board, const Move& mv, const std::string& player,
                     }
                 }
                 if (!success) {
-                    mv = moves[0];
-                Board new_board = cached_simulate(board, mv, player, rows, cols, score_cols);
-                double board_value = alphabeta(new_board, depth - 1, alpha, beta, false, rows, cols, score_cols);
-                cout << "Value below 100" << endl;
+                mv = to_move<G>(moves[0]);
                 for (size_t i = 0; i < moves.size(); ++i) {
-                    const Board& new_board_cached = child_boards[i];
-                    double bv = alphabeta(new_board_cached, depth - 1, alpha, beta, false, rows, cols, score_cols);
-                    if (bv > best_value) { best_value = bv; mv = moves[i]; }
+                    Score bv = child_value(child_boards[i], depth - 1, alpha);
+                    if (bv > best_value) { best_value = bv; mv = to_move<G>(moves[i]); }
                 }
                 return mv;
                 }
             }
             return mv;
         }
-        Move best_move = moves[0];
-        best_value = -std::numeric_limits<double>::infinity();
+        size_t best_move = 0;
+        best_value = -SCORE_INF;
         std::vector<size_t> order(moves.size());
         for (size_t i = 0; i < moves.size(); ++i) order[i] = i;
         std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
-            double ea = cached_evaluate(child_boards[a], rows, cols, score_cols);
-            double eb = cached_evaluate(child_boards[b], rows, cols, score_cols);
-            return ea > eb;
+            return cached_evaluate<G, Us>(child_boards[a]) > cached_evaluate<G, Us>(child_boards[b]);
         });
 
-        for (size_t oi = 0; oi < order.size(); ++oi) {
-            size_t i = order[oi];
-            const Board& new_board = child_boards[i];
-            double board_value = alphabeta(new_board, search_depth - 1, alpha, beta, false, rows, cols, score_cols);
-
-            if (board_value > best_value) { best_value = board_value; best_move = moves[i]; }
-
-            alpha = std::max(alpha, best_value);
+        // Iterative deepening under the time manager, best moves of each iteration first in
+        // the next. A root the table already holds (searched on our last turn or while
+        // pondering) starts at the depth stored for it, with its best move first.
+        int start_depth = 1;
+        Symmetry sym;
+        if (const TTEntry* rt = tt.find(tt_key(root, Us, sym))) {
+            PackedMove seed = transform_move<G>(rt->move, sym);
+            auto pos = std::find_if(order.begin(), order.end(), [&](size_t i) { return moves[i] == seed; });
+            if (pos != order.end()) std::rotate(order.begin(), pos, pos + 1);
+            start_depth = std::clamp(int(rt->depth), 1, search_depth);
         }
-        return best_move;
+        best_move = order.front();
+        double progress = double(std::max(packed_scoring_count<G, Us>(root), packed_scoring_count<G, Them>(root))) / G::SCORE_W;
+        time_manager.start(current_player_time, opponent_time, rows, moves_played, progress, moves.size());
+        search_deadline = time_manager.deadline();
+        timed_search = true;
+        search_nodes = 0;
+        std::vector<Score> values(moves.size());
+        for (int depth = start_depth; depth <= MAX_SEARCH_DEPTH; ++depth) {
+            // the previous best is searched first, so a move of an interrupted iteration
+            // that beats it is better at this depth as well
+            Score iteration_value = -SCORE_INF;
+            size_t iteration_best = best_move;
+            alpha = -SCORE_INF;
+            for (size_t oi = 0; oi < order.size(); ++oi) {
+                size_t i = order[oi];
+                Score board_value = child_value(child_boards[i], depth - 1, alpha);
+                if (stopped()) break;
+                values[i] = board_value;
+
+                if (board_value > iteration_value) { iteration_value = board_value; iteration_best = i; }
+
+                alpha = std::max(alpha, iteration_value);
+            }
+            if (iteration_value > -SCORE_INF) { best_value = iteration_value; best_move = iteration_best; }
+            if (stopped()) break;
+            publish_iteration(to_move<G>(moves[best_move]), depth, best_value);
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return values[a] > values[b]; });
+            if (std::abs(best_value) >= MATE_BOUND) break;
+            if (!time_manager.next_iteration(best_move) && depth >= search_depth) break;
+        }
+        timed_search = false;
+        stop_requested = false;
+        // Close to the opponent's row, skip moves after which it provably forces a win
+        if (G::SCORE_W - packed_scoring_count<G, Them>(root) <= PROOF_TRIGGER) {
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return values[a] > values[b]; });
+            for (size_t oi = 0; oi < order.size() && oi < PROOF_DEFENCES; ++oi) {
+                ProofNumberSearch<G, Them> pns;
+                if (pns.solve(child_boards[order[oi]], PROOF_NODES / PROOF_DEFENCES) != ProofResult::PROVEN) {
+                    best_move = order[oi];
+                    break;
+                }
+            }
+        }
+        return to_move<G>(moves[best_move]);
     }
 
-private:
     std::string player;
-    std::string opponent;
-    int search_depth;
-    bool set_board;
-    int fast_depth;
-    MoveList mv_list_small;
-    MoveList mv_list_medium;
-    MoveList mv_list_large;
+    Side side;
+    int search_depth;   // iterations up to this depth run regardless of the soft time budget
+    bool set_board = false;
     std::vector<Move> mv_list;
     std::random_device rd;
     std::mt19937 gen;
-    struct TTEntry { double value; int depth; bool has_value; };
-    std::unordered_map<uint64_t, TTEntry> tt;
-    
-    std::unordered_map<uint64_t, double> eval_cache;
+    static constexpr int QUIESCE_DEPTH = 2;
+    static constexpr int PONDER_MAX_DEPTH = 8;
+    static constexpr int MAX_SEARCH_DEPTH = 32;
+    static constexpr uint32_t DEADLINE_CHECK_NODES = 1024;
+    // proof-number search runs once a side is this many stones from filling its row
+    static constexpr int PROOF_TRIGGER = 2;
+    static constexpr size_t PROOF_NODES = 100000;
+    static constexpr size_t PROOF_DEFENCES = 4;
+    enum Bound : uint8_t { BOUND_EXACT, BOUND_LOWER, BOUND_UPPER };
+    // `age` is the choose generation that last wrote the entry
+    struct TTEntry { Score value; int8_t depth; Bound bound; PackedMove move; uint8_t age; };
+    BoundedCache<TTEntry> tt;
+    uint8_t tt_generation = 0;
+    std::shared_ptr<CacheBudget> cache_budget; // bounds tt, and eval_cache to half as much
+
+    // Once the agent's share of the cache budget is used up, entries of earlier turns and
+    // then shallower ones make room for new ones.
+    void tt_store(uint64_t key, const TTEntry& entry) {
+        tt.store(key, entry, cache_budget->share(), [](const TTEntry& old, const TTEntry& e) {
+            return old.age != e.age || old.depth <= e.depth;
+        });
+    }
+
+    std::unordered_set<uint64_t> expected_roots; // piece keys one opponent move after our last reply
+    bool symmetric_keys = false;
+
+    std::vector<uint64_t> path_keys;         // positions from the search root to the current node
+    std::unordered_set<uint64_t> game_keys;  // positions of the game so far
+    bool path_dependent = false;             // whether the last node's value came from a repetition
+    Score draw_score = 0;
+
+    bool ponder_enabled = false;
+    std::thread ponder_thread;
+    std::atomic<bool> stop_requested{false};
+
+    TimeManager time_manager;
+    bool timed_search = false;
+    TimeManager::Clock::time_point search_deadline;
+    uint64_t search_nodes = 0;
+
+    bool resumable_owned = false; // a ResumableSearch of this agent exists
+
+    std::thread search_thread;
+    std::atomic<bool> search_stop{false};
+    std::mutex search_info_mutex;
+    std::condition_variable search_done;
+    SearchInfo search_info;
+    TimeManager::Clock::time_point search_started;
+    int moves_played = 0;
     
-    std::unordered_map<uint64_t, MoveList> moves_cache;
+    BoundedCache<Score> eval_cache;
+    EvalCaches eval_caches;
     
-    std::unordered_map<uint64_t, Board> board_cache;
+    BoundedCache<std::shared_ptr<const PackedMoveList>> moves_cache;
+};
+
+// Analysis of many positions at once, spread over the shared thread pool. Each position gets
+// an agent of its own, so results do not depend on which other positions are in the batch.
+// `depth`, `seconds` and `multipv` are as for StudentAgent::analyze.
+std::vector<Analysis> analyze_batch(const std::vector<Board>& boards, const std::vector<std::string>& players, int rows, int cols, const std::vector<int>& score_cols, int depth, double seconds, int multipv) {
+    if (players.size() != boards.size()) throw std::invalid_argument("analyze_batch: expected one player per board");
+    if (depth <= 0 && seconds <= 0) throw std::invalid_argument("analyze_batch: give a depth or a time limit");
+    with_geometry(rows, cols, score_cols, [](auto) {}); // reject an unknown board size before fanning out
+    std::vector<Analysis> results(boards.size());
+    // parallel_for tasks must not throw: a bad player name or board is kept per position and
+    // the first one rethrown once every position is done
+    std::vector<std::exception_ptr> errors(boards.size());
+    shared_pool().parallel_for(boards.size(), [&](size_t i) {
+        try {
+            StudentAgent agent(players[i]);
+            results[i] = agent.analyze(boards[i], rows, cols, score_cols, depth, seconds, multipv);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    });
+    for (const auto& error : errors)
+        if (error) std::rethrow_exception(error);
+    return results;
+}
+
+// ---- Search executor ----
+// Interleaves many resumable searches on the calling thread. Every round gives each
+// unfinished search a slice of nodes in turn, so hundreds of positions progress together on
+// one core, and a search is cancelled by dropping it between slices.
+class SearchExecutor {
+public:
+    // Search `board` to `depth` with `agent`'s tables, valued like StudentAgent::alphabeta.
+    // An agent takes part in one search at a time.
+    int add(StudentAgent& agent, const Board& board, int depth, bool maximizing_player, int rows, int cols, const std::vector<int>& score_cols) {
+        int id = next_id++;
+        tasks[id] = agent.resumable_search(board, depth, maximizing_player, rows, cols, score_cols);
+        return id;
+    }
+
+    // Drop a search, finished or not.
+    void cancel(int id) { tasks.erase(id); }
+
+    // One slice for every unfinished search; returns how many are still unfinished.
+    size_t run_round(uint64_t slice_nodes) {
+        size_t unfinished = 0;
+        for (auto& t : tasks)
+            if (!t.second->finished() && !t.second->step(slice_nodes)) ++unfinished;
+        return unfinished;
+    }
+
+    void run(uint64_t slice_nodes) {
+        while (run_round(slice_nodes)) {}
+    }
+
+    bool finished(int id) const { return task(id).finished(); }
+    double value(int id) const {
+        if (!task(id).finished()) throw std::logic_error("search " + std::to_string(id) + " is not finished");
+        return task(id).value();
+    }
+    size_t size() const { return tasks.size(); }
+
+private:
+    const ResumableTask& task(int id) const {
+        auto it = tasks.find(id);
+        if (it == tasks.end()) throw std::out_of_range("no search " + std::to_string(id));
+        return *it->second;
+    }
+
+    std::map<int, std::unique_ptr<ResumableTask>> tasks;
+    int next_id = 0;
+};
+
+// ---- Agent host ----
+// Many games in one process. Each session is a StudentAgent; their searches queue on one
+// shared worker pool and start in submission order, so a game waits for no more than the
+// searches submitted before its own, and the wait is taken off its clock. Geometry, Zobrist
+// keys and pattern tables are process-wide constants already shared by every session; the
+// sessions share one cache budget, each filling an equal share of it.
+class AgentHost {
+public:
+    explicit AgentHost(size_t threads = 0, size_t cache_entries = DEFAULT_HOST_CACHE_ENTRIES)
+        : cache_budget(std::make_shared<CacheBudget>(cache_entries)), pool(threads) {}
+    ~AgentHost() {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        for (auto& s : sessions) s.second->stop();
+    }
+
+    int create_session(const std::string& player) {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        int id = next_id++;
+        sessions[id] = std::make_unique<StudentAgent>(player, cache_budget);
+        return id;
+    }
+
+    void close_session(int id) {
+        std::unique_ptr<StudentAgent> agent;
+        {
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            auto it = sessions.find(id);
+            if (it == sessions.end()) return;
+            agent = std::move(it->second);
+            sessions.erase(it);
+        }
+        agent->stop();
+        agent->wait();
+    }
+
+    // The agent of a session, for calls outside the search queue. Not to be used while the
+    // session has a search pending.
+    StudentAgent& session(int id) {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        auto it = sessions.find(id);
+        if (it == sessions.end()) throw std::out_of_range("no session " + std::to_string(id));
+        return *it->second;
+    }
+
+    void submit(int id, const Board& board, int rows, int cols, const std::vector<int>& score_cols, float current_player_time, float opponent_time) {
+        StudentAgent& agent = session(id);
+        agent.begin_search();
+        pool.enqueue([&agent, board, rows, cols, score_cols, current_player_time, opponent_time] {
+            agent.run_search(board, rows, cols, score_cols, current_player_time, opponent_time);
+        });
+    }
+
+    SearchInfo poll(int id) { return session(id).poll(); }
+    void stop(int id) { session(id).stop(); }
+    Move wait(int id) { return session(id).wait(); }
+
+    size_t session_count() {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        return sessions.size();
+    }
+    size_t threads() const { return pool.size(); }
+
+    static constexpr size_t DEFAULT_HOST_CACHE_ENTRIES = size_t(1) << 23;
+
+private:
+    std::shared_ptr<CacheBudget> cache_budget;
+    int next_id = 0;
+    std::mutex sessions_mutex;
+    std::map<int, std::unique_ptr<StudentAgent>> sessions;
+    ThreadPool pool; // last, so its workers finish before the sessions go
+};
+
+// StudentAgent behind the BaseAgent interface of agent.h (see get_agent).
+class StudentBaseAgent : public BaseAgent {
+public:
+    explicit StudentBaseAgent(const std::string& player) : BaseAgent(player), agent(player) {}
+
+    std::optional<Move> choose(const Board& board, int rows, int cols, const std::vector<int>& score_cols,
+                               double current_player_time, double opponent_time) override {
+        return agent.choose(board, rows, cols, score_cols, float(current_player_time), float(opponent_time));
+    }
+
+private:
+    StudentAgent agent;
+};
+
+std::unique_ptr<BaseAgent> make_student_agent(const std::string& player) {
+    return std::make_unique<StudentBaseAgent>(player);
+}
+
+#ifndef STUDENT_AGENT_NATIVE
+// ---- Game session ----
+// A game kept on the C++ side. The session holds the board, packed, so a turn crosses the
+// Python boundary as one move dict each way instead of a full board in and a Move object out.
+// The host passes every move the opponent plays to apply; a move that does not fit the held
+// board (or a position_key that differs from the host's) means the two have drifted apart,
+// and the host resyncs with the full board once.
+class GameSession {
+public:
+    GameSession(const std::string& player, int rows, int cols, const std::vector<int>& score_cols)
+        : agent(player), player(player), rows(rows), cols(cols), score_cols(score_cols),
+          position(make_position(rows, cols, score_cols)) {
+        position->reset(create_default_start_board(rows, cols));
+    }
+
+    void resync(const Board& new_board, const std::string& side_to_move) {
+        position->reset(new_board);
+        to_move = side_of(side_to_move);
+    }
+
+    // Play the opponent's move; false, with the board unchanged, if it is illegal there.
+    bool apply(const py::dict& move) {
+        if (side_name(to_move) == player) throw std::logic_error("it is " + player + "'s turn, not the opponent's");
+        return play(move_from_dict(move));
+    }
+
+    // Our move on the held board, already played on it, in the host's dict format.
+    py::dict choose(float current_player_time, float opponent_time) {
+        if (side_name(to_move) != player) throw std::logic_error("it is not " + player + "'s turn");
+        Move mv;
+        {
+            py::gil_scoped_release release;
+            mv = agent.choose(position->board(), rows, cols, score_cols, current_player_time, opponent_time);
+            if (!play(mv)) throw std::runtime_error(player + " chose a move that is illegal on the session board");
+        }
+        return move_to_dict(mv);
+    }
+
+    uint64_t position_key() const { return position->key(to_move); }
+    // The key position_key would give for `board` with `side_to_move` to move.
+    uint64_t key_of(const Board& board, const std::string& side_to_move) const {
+        return with_geometry(rows, cols, score_cols, [&](auto geometry) {
+            using G = decltype(geometry);
+            return pack_board<G>(board).key_for(side_of(side_to_move));
+        });
+    }
+    Board current_board() const { return position->board(); }
+    std::string side_to_move() const { return side_name(to_move); }
+    StudentAgent& student_agent() { return agent; }
+
+private:
+    // The held board, packed for its layout.
+    class Position {
+    public:
+        virtual ~Position() = default;
+        virtual void reset(const Board& board) = 0;
+        // Play `move` for `side`; false, with the board unchanged, if it is illegal.
+        virtual bool play(const Move& move, Side side) = 0;
+        virtual uint64_t key(Side to_move) const = 0;
+        virtual Board board() const = 0;
+    };
+
+    template <class G>
+    class PackedPosition : public Position {
+    public:
+        void reset(const Board& board) override { packed = pack_board<G>(board); }
+        bool play(const Move& move, Side side) override {
+            const PackedMove pm = from_move<G>(move);
+            bool legal = side == CIRCLE ? packed_legal<G, CIRCLE>(packed, pm) : packed_legal<G, SQUARE>(packed, pm);
+            if (legal) apply_packed_move(packed, pm);
+            return legal;
+        }
+        uint64_t key(Side to_move) const override { return packed.key_for(to_move); }
+        Board board() const override { return unpack_board(packed); }
+
+    private:
+        PackedBoard<G> packed;
+    };
+
+    static std::unique_ptr<Position> make_position(int rows, int cols, const std::vector<int>& score_cols) {
+        return with_geometry(rows, cols, score_cols, [](auto geometry) -> std::unique_ptr<Position> {
+            return std::make_unique<PackedPosition<decltype(geometry)>>();
+        });
+    }
+
+    bool play(const Move& move) {
+        // from_move reads any other action as a rotation
+        if (move.action != "move" && move.action != "push" && move.action != "flip" && move.action != "rotate")
+            return false;
+        if (!position->play(move, to_move)) return false;
+        to_move = other_side(to_move);
+        return true;
+    }
+
+    static Move move_from_dict(const py::dict& d) {
+        Move m;
+        m.action = d["action"].cast<std::string>();
+        m.from = d["from"].cast<std::vector<int>>();
+        if (d.contains("to") && !d["to"].is_none()) m.to = d["to"].cast<std::vector<int>>();
+        if (d.contains("pushed_to") && !d["pushed_to"].is_none()) m.pushed_to = d["pushed_to"].cast<std::vector<int>>();
+        if (d.contains("orientation") && !d["orientation"].is_none()) m.orientation = d["orientation"].cast<std::string>();
+        return m;
+    }
+
+    // the fields the game engine reads for each action
+    static py::dict move_to_dict(const Move& m) {
+        py::dict d;
+        d["action"] = m.action;
+        d["from"] = m.from;
+        if (m.action == "move" || m.action == "push") d["to"] = m.to;
+        if (m.action == "push") d["pushed_to"] = m.pushed_to;
+        if (m.action == "flip") d["orientation"] = m.orientation;
+        return d;
+    }
+
+    StudentAgent agent;
+    std::string player;
+    int rows, cols;
+    std::vector<int> score_cols;
+    std::unique_ptr<Position> position;
+    Side to_move = CIRCLE;
 };
 
 PYBIND11_MODULE(student_agent_module, m) {
@@ -1320,9 +3057,80 @@ PYBIND11_MODULE(student_agent_module, m) {
 
     py::class_<StudentAgent>(m, "StudentAgent")
         .def(py::init<const std::string&>())
-        .def("choose", &StudentAgent::choose)
+        .def("choose", &StudentAgent::choose, py::call_guard<py::gil_scoped_release>())
         .def("check_move", &StudentAgent::check_move)
-        .def("alphabeta", &StudentAgent::alphabeta);
+        .def("set_symmetric_keys", &StudentAgent::set_symmetric_keys)
+        .def("set_draw_score", &StudentAgent::set_draw_score)
+        .def("alphabeta", static_cast<double (StudentAgent::*)(const Board&, int, double, double, bool, int, int, const std::vector<int>&)>(&StudentAgent::alphabeta),
+             py::call_guard<py::gil_scoped_release>())
+        .def("set_ponder", &StudentAgent::set_ponder)
+        .def("stop_pondering", &StudentAgent::stop_pondering, py::call_guard<py::gil_scoped_release>())
+        .def("start_search", &StudentAgent::start_search, py::call_guard<py::gil_scoped_release>())
+        .def("poll", &StudentAgent::poll)
+        .def("stop", &StudentAgent::stop)
+        .def("wait", &StudentAgent::wait, py::call_guard<py::gil_scoped_release>())
+        .def("analyze", &StudentAgent::analyze, py::arg("board"), py::arg("rows"), py::arg("cols"), py::arg("score_cols"),
+             py::arg("depth") = 0, py::arg("seconds") = 0.0, py::arg("multipv") = 1, py::call_guard<py::gil_scoped_release>());
+
+    py::class_<AgentHost>(m, "AgentHost")
+        .def(py::init<size_t, size_t>(), py::arg("threads") = 0,
+             py::arg("cache_entries") = AgentHost::DEFAULT_HOST_CACHE_ENTRIES)
+        .def("create_session", &AgentHost::create_session)
+        .def("close_session", &AgentHost::close_session, py::call_guard<py::gil_scoped_release>())
+        .def("session", &AgentHost::session, py::return_value_policy::reference_internal)
+        .def("submit", &AgentHost::submit, py::call_guard<py::gil_scoped_release>())
+        .def("poll", &AgentHost::poll)
+        .def("stop", &AgentHost::stop)
+        .def("wait", &AgentHost::wait, py::call_guard<py::gil_scoped_release>())
+        .def("session_count", &AgentHost::session_count)
+        .def("threads", &AgentHost::threads);
+
+    py::class_<SearchExecutor>(m, "SearchExecutor")
+        .def(py::init<>())
+        .def("add", &SearchExecutor::add, py::keep_alive<1, 2>())
+        .def("cancel", &SearchExecutor::cancel)
+        .def("run_round", &SearchExecutor::run_round, py::call_guard<py::gil_scoped_release>())
+        .def("run", &SearchExecutor::run, py::call_guard<py::gil_scoped_release>())
+        .def("finished", &SearchExecutor::finished)
+        .def("value", &SearchExecutor::value)
+        .def("size", &SearchExecutor::size);
+
+    py::class_<GameSession>(m, "GameSession")
+        .def(py::init<const std::string&, int, int, const std::vector<int>&>())
+        .def("resync", &GameSession::resync)
+        .def("apply", &GameSession::apply)
+        .def("choose", &GameSession::choose)
+        .def("position_key", &GameSession::position_key)
+        .def("key_of", &GameSession::key_of)
+        .def("board", &GameSession::current_board)
+        .def("side_to_move", &GameSession::side_to_move)
+        .def("agent", &GameSession::student_agent, py::return_value_policy::reference_internal);
+
+    py::class_<MoveBatch>(m, "MoveBatch")
+        .def_readonly("counts", &MoveBatch::counts)
+        .def_property_readonly("moves", [](const MoveBatch& b) { return py::bytes(b.moves); });
+
+    py::class_<AnalysisLine>(m, "AnalysisLine")
+        .def_readonly("move", &AnalysisLine::move)
+        .def_readonly("value", &AnalysisLine::value)
+        .def_readonly("pv", &AnalysisLine::pv);
+
+    py::class_<Analysis>(m, "Analysis")
+        .def_readonly("best_move", &Analysis::best_move)
+        .def_readonly("value", &Analysis::value)
+        .def_readonly("pv", &Analysis::pv)
+        .def_readonly("lines", &Analysis::lines)
+        .def_readonly("depth", &Analysis::depth)
+        .def_readonly("nodes", &Analysis::nodes)
+        .def_readonly("elapsed", &Analysis::elapsed);
+
+    py::class_<SearchInfo>(m, "SearchInfo")
+        .def_readonly("running", &SearchInfo::running)
+        .def_readonly("best_move", &SearchInfo::best_move)
+        .def_readonly("depth", &SearchInfo::depth)
+        .def_readonly("value", &SearchInfo::value)
+        .def_readonly("nodes", &SearchInfo::nodes)
+        .def_readonly("elapsed", &SearchInfo::elapsed);
     
     m.def("in_bounds", &in_bounds);
     m.def("score_cols_for", &score_cols_for);
@@ -1333,5 +3141,17 @@ PYBIND11_MODULE(student_agent_module, m) {
     m.def("get_opponent", &get_opponent);
     m.def("generate_all_moves", &generate_all_moves);
     m.def("basic_evaluate_board", &basic_evaluate_board);
+    m.def("pack_boards", [](const std::vector<Board>& boards, int rows, int cols, const std::vector<int>& score_cols) {
+        return py::bytes(pack_boards(boards, rows, cols, score_cols));
+    });
+    m.def("evaluate_packed_boards", &evaluate_packed_boards, py::call_guard<py::gil_scoped_release>());
+    m.def("pack_boards_soa", [](const std::vector<Board>& boards, int rows, int cols, const std::vector<int>& score_cols) {
+        return py::bytes(pack_boards_soa(boards, rows, cols, score_cols));
+    });
+    m.def("generate_moves_soa", &generate_moves_soa, py::call_guard<py::gil_scoped_release>());
+    m.def("analyze_batch", &analyze_batch, py::arg("boards"), py::arg("players"), py::arg("rows"), py::arg("cols"),
+          py::arg("score_cols"), py::arg("depth") = 0, py::arg("seconds") = 0.0, py::arg("multipv") = 1,
+          py::call_guard<py::gil_scoped_release>());
     m.def("count_stones_in_scoring_area", &count_stones_in_scoring_area);
 }
+#endif
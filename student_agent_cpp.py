@@ -354,6 +354,69 @@ class StudentAgent(BaseAgent):
         return moves
 
 
+class StudentGameSession:
+    """
+    Student Agent that keeps the game board on the C++ side.
+
+    Instead of converting the whole board every turn, the host reports each opponent
+    move with opponent_moved() and gets our move back as a ready-made dict. The full
+    board is only sent again when the C++ copy has drifted from the host's.
+    """
+
+    def __init__(self, player: str, rows: int, cols: int, score_cols: List[int]):
+        self.player = player
+        self.session = s1.GameSession(player, rows, cols, score_cols)
+
+    @staticmethod
+    def _convert_board(board: List[List[Any]]) -> List[List[Dict[str, str]]]:
+        converted = []
+        for row in board:
+            converted_row = []
+            for cell in row:
+                if cell is None:
+                    converted_row.append({})
+                else:
+                    piece_dict = {"owner": cell.owner, "side": cell.side}
+                    if getattr(cell, 'orientation', None) not in (None, 'None'):
+                        piece_dict["orientation"] = cell.orientation
+                    converted_row.append(piece_dict)
+            converted.append(converted_row)
+        return converted
+
+    def resync(self, board: List[List[Any]], side_to_move: str) -> None:
+        """Replace the held board with the host's (Piece objects or None per cell)."""
+        self.session.resync(self._convert_board(board), side_to_move)
+
+    def position_key(self) -> int:
+        """Key of the held position with its side to move; equal keys mean equal positions."""
+        return self.session.position_key()
+
+    def opponent_moved(self, move: Dict[str, Any], board: Optional[List[List[Any]]] = None,
+                       expected_key: Optional[int] = None) -> None:
+        """
+        Play the opponent's move on the held board. The host can pass the key it expects
+        afterwards (position_key of a session in step with its game) or its board after the
+        move. If the move does not fit the held board, or the held position then differs from
+        the expected key or from `board`, the held board is resynced from `board`.
+        """
+        applied = self.session.apply(move)
+        converted = None
+        if expected_key is None and board is not None:
+            converted = self._convert_board(board)
+            expected_key = self.session.key_of(converted, self.player)
+        if applied and (expected_key is None or expected_key == self.session.position_key()):
+            return
+        if board is None:
+            if not applied:
+                raise ValueError(f"move {move} does not fit the session board and no board was given")
+            raise ValueError("the session board differs from the expected position and no board was given")
+        self.session.resync(converted if converted is not None else self._convert_board(board), self.player)
+
+    def choose(self, current_player_time: float, opponent_time: float) -> Optional[Dict[str, Any]]:
+        """Choose and play our move; returns it in the game engine's dict format."""
+        return self.session.choose(current_player_time, opponent_time)
+
+
 def test_student_agent():
     """
     Basic test to verify the student agent can be created and make moves.
@@ -0,0 +1,85 @@
+#pragma once
+// thread_pool.h
+// Fixed set of worker threads running queued tasks in submission order. Destroying the
+// pool runs the tasks still queued, then joins the workers.
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // threads == 0 takes one worker per hardware thread
+    explicit ThreadPool(size_t threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < threads; ++i) workers.emplace_back([this] { work(); });
+    }
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        ready.notify_all();
+        for (auto& w : workers) w.join();
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push(std::move(task));
+        }
+        ready.notify_one();
+    }
+
+    // Run f(i) for every i in [0, n) in a few chunks per worker and return once all are
+    // done. f must not throw, and the caller must not be one of this pool's workers.
+    template <class F>
+    void parallel_for(size_t n, F&& f) {
+        const size_t chunks = std::min(n, workers.size() * CHUNKS_PER_WORKER);
+        std::mutex done_mutex;
+        std::condition_variable done;
+        size_t left = chunks;
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t begin = n * c / chunks, end = n * (c + 1) / chunks;
+            enqueue([&, begin, end] {
+                for (size_t i = begin; i < end; ++i) f(i);
+                std::lock_guard<std::mutex> lock(done_mutex);
+                if (--left == 0) done.notify_one();
+            });
+        }
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done.wait(lock, [&] { return left == 0; });
+    }
+
+    size_t size() const { return workers.size(); }
+
+private:
+    // chunks beyond one per worker even out chunks that take longer than others
+    static constexpr size_t CHUNKS_PER_WORKER = 4;
+
+    void work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return closing || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool closing = false;
+};